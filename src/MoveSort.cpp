@@ -1,12 +1,6 @@
 #include "MoveSort.h"
 
-alignas(64) Move killerMoves[MAX_PLY][2]; // each ply can have two killer moves
-alignas(64) Move counterMove[64][64];
-alignas(64) int16_t moveHistory[2][64][64];                  // History for [isWhite][from][to]
-alignas(64) int16_t captureHistory[64][64][PieceType::KING]; // indexed as [from][to][victimPieceType-1]
-alignas(64) int16_t continuationHistory[CONTINUATION_HISTORY_SIZE][6][64][6][64];
-
-MoveVal ScoreMove(const Board& board, Move m)
+MoveVal ScoreMove(const Board& board, const SearchHistory& history, Move m)
 {
     const Piece piece = board.getSQ(m.from());
     const PieceType pType = getType(piece);
@@ -20,28 +14,28 @@ MoveVal ScoreMove(const Board& board, Move m)
     {
         v.score = pieceScores[getType(m.promotion())] + PROMOTION_BONUS;
     }
-    else if (killerMoves[board.getPly()][0] == m)
+    else if (history.killerMoves[board.getPly()][0] == m)
     {
         v.score = KILLER_MOVE_BONUS;
     }
-    else if (killerMoves[board.getPly()][1] == m)
+    else if (history.killerMoves[board.getPly()][1] == m)
     {
         v.score = KILLER_MOVE_BONUS - 10;
     }
-    else if (prevMove.getMove() && counterMove[prevMove.from()][prevMove.to()] == m)
+    else if (prevMove.getMove() && history.counterMove[prevMove.from()][prevMove.to()] == m)
     {
         v.score = COUNTERMOVE_BONUS;
     }
     else
     {
-        v.score += moveHistory[board.whiteToMove][m.from()][m.to()];
+        v.score += history.moveHistory[board.whiteToMove][m.from()][m.to()];
         const BoardState* prevState = board.getState();
         PieceType moved = getType(board.getSQ(m.from()));
         for (int i = 0; i < CONTINUATION_HISTORY_SIZE; i++)
         {
             if (!prevState || prevState->moved == EMPTY)
                 break;
-            v.score += continuationHistory[i][getType(prevState->moved) - 1][prevState->move.to()][moved - 1][m.to()];
+            v.score += history.continuationHistory[i][getType(prevState->moved) - 1][prevState->move.to()][moved - 1][m.to()];
 
             prevState = prevState->prev;
         }
@@ -55,33 +49,189 @@ MoveVal ScoreMove(const Board& board, Move m)
     return v;
 }
 
-MoveVal ScoreMoveQ(const Board& board, Move m)
+MoveVal ScoreMoveQ(const Board& board, const SearchHistory& history, Move m)
 {
     MoveVal v = {m, 0};
-    PieceType pType = getType(board.getSQ(m.from()));
 
     PieceType victimType = getType(board.getSQ(m.to()));
 
     if (m.to() == board.getEnPassantSqr())
         victimType = PAWN;
 
-    v.score += 2 * captureHistory[m.from()][m.to()][victimType - 1] + pieceScores[victimType] * 4;
+    v.score += 2 * history.captureHistory[m.from()][m.to()][victimType - 1] + pieceScores[victimType] * 4;
 
     v.score += Mvv_Lva_Score(board, m) + CAPTURE_BONUS;
 
-    if (sqrToBB(m.to()) & board.getAttacked(~board.sideToMove)) // penalty for moving piece to attacked square
-        v.score += ATTACKED_PENALTY - pieceScores[pType];
-
     const BoardState* prevState = board.getState();
     PieceType moved = getType(board.getSQ(m.from()));
     for (int i = 0; i < CONTINUATION_HISTORY_SIZE; i++)
     {
         if (!prevState || prevState->moved == EMPTY)
             break;
-        v.score += continuationHistory[i][getType(prevState->moved) - 1][prevState->move.to()][moved - 1][m.to()];
+        v.score += history.continuationHistory[i][getType(prevState->moved) - 1][prevState->move.to()][moved - 1][m.to()];
 
         prevState = prevState->prev;
     }
 
     return v;
+}
+MovePicker::MovePicker(Board& board, const SearchHistory& history, Move ttMove, SortType type)
+    : board(board), history(history), ttMove(0), killers{}, counterMove(0), cur(moveVals), end(moveVals),
+      badCapturesEnd(moveVals)
+{
+    if (board.getNumChecks())
+        stage = STAGE_EVASION_TT_MOVE;
+    else if (type == QUIESCENCE)
+        stage = STAGE_QS_TT_MOVE;
+    else
+        stage = STAGE_TT_MOVE;
+
+    // the TT move can come from a hash collision so it has to be validated
+    const bool noisy = ttMove.isType<CAPTURE>() || ttMove.isType<PROMOTION>();
+    if (ttMove.getMove() && (stage != STAGE_QS_TT_MOVE || noisy) && board.isPseudoLegal(ttMove) &&
+        board.isLegal(ttMove))
+        this->ttMove = ttMove;
+}
+
+MoveVal MovePicker::PickBest()
+{
+    MoveVal* best = cur;
+    for (MoveVal* v = cur + 1; v < end; v++)
+    {
+        if (v->score > best->score)
+            best = v;
+    }
+
+    std::swap(*best, *cur);
+    return *cur++;
+}
+
+bool MovePicker::IsUsableQuiet(Move m) const
+{
+    if (!m.getMove() || m == ttMove || m.isType<CAPTURE>() || m.isType<PROMOTION>())
+        return false;
+
+    return board.isPseudoLegal(m) && board.isLegal(m);
+}
+
+template <MoveType type>
+void MovePicker::GenerateAndScore()
+{
+    MoveList moves;
+    board.generateMoves<type>(&moves);
+
+    for (unsigned int i = 0; i < moves.GetSize(); i++)
+    {
+        const Move m = moves[i];
+        if (m == ttMove)
+            continue;
+
+        // killers and the counter move were already returned (or aren't legal here)
+        if constexpr (type == QUIET)
+        {
+            if (m == killers[0] || m == killers[1] || m == counterMove)
+                continue;
+        }
+
+        *end++ = m.isType<CAPTURE>() ? ScoreMoveQ(board, history, m) : ScoreMove(board, history, m);
+    }
+}
+
+Move MovePicker::Next()
+{
+    switch (stage)
+    {
+    case STAGE_TT_MOVE:
+    case STAGE_EVASION_TT_MOVE:
+    case STAGE_QS_TT_MOVE:
+        stage++;
+        if (ttMove.getMove())
+            return ttMove;
+        return Next();
+
+    case STAGE_GEN_CAPTURES:
+    case STAGE_GEN_QS_CAPTURES:
+        GenerateAndScore<CAPTURE>();
+        stage++;
+        return Next();
+
+    case STAGE_GOOD_CAPTURES:
+        while (cur < end)
+        {
+            const MoveVal best = PickBest();
+            if (board.see(best.m, 0))
+                return best.m;
+
+            *badCapturesEnd++ = best; // cur is always ahead of badCapturesEnd
+        }
+
+        stage++;
+        killers[0] = history.killerMoves[board.getPly()][0];
+        killers[1] = history.killerMoves[board.getPly()][1];
+        return Next();
+
+    case STAGE_KILLER_1:
+        stage++;
+        if (IsUsableQuiet(killers[0]))
+            return killers[0];
+        return Next();
+
+    case STAGE_KILLER_2:
+        stage++;
+        if (killers[1] != killers[0] && IsUsableQuiet(killers[1]))
+            return killers[1];
+        return Next();
+
+    case STAGE_COUNTER_MOVE: {
+        stage++;
+        const Move prevMove = board.getState()->move;
+        if (prevMove.getMove())
+        {
+            const Move counter = history.counterMove[prevMove.from()][prevMove.to()];
+            if (counter != killers[0] && counter != killers[1] && IsUsableQuiet(counter))
+            {
+                counterMove = counter;
+                return counterMove;
+            }
+        }
+        return Next();
+    }
+
+    case STAGE_GEN_QUIETS:
+        cur = end; // the captures before end have all been returned or moved to the bad captures
+        GenerateAndScore<QUIET>();
+        stage++;
+        return Next();
+
+    case STAGE_QUIETS:
+        if (cur < end)
+            return PickBest().m;
+
+        stage++;
+        cur = moveVals;
+        return Next();
+
+    case STAGE_BAD_CAPTURES:
+        if (cur < badCapturesEnd)
+            return (cur++)->m; // already in order from the good capture stage
+
+        stage = STAGE_DONE;
+        return 0;
+
+    case STAGE_GEN_EVASIONS:
+        GenerateAndScore<ALL_MOVES>();
+        stage++;
+        return Next();
+
+    case STAGE_EVASIONS:
+    case STAGE_QS_CAPTURES:
+        if (cur < end)
+            return PickBest().m;
+
+        stage = STAGE_DONE;
+        return 0;
+
+    default:
+        return 0;
+    }
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "move.h"
 
 #include <algorithm>
+#include <cstring>
 
 #define CAPTURE_BONUS 4000
 #define PROMOTION_BONUS 5000
@@ -39,118 +40,168 @@ enum SortType
     QUIESCENCE
 };
 
-MoveVal ScoreMove(const Board& board, Move m);
-MoveVal ScoreMoveQ(const Board& board, Move m);
-
-struct MoveSorter
+/**
+ * @brief Move ordering heuristics gathered during search. Every search thread owns one, so independent searchers
+ * (and the threads of a single searcher) never share them
+ */
+struct SearchHistory
 {
-    MoveVal moveVals[256];
-    unsigned int size;
+    alignas(64) Move killerMoves[MAX_PLY][2];                    // each ply can have two killer moves
+    alignas(64) Move counterMove[64][64];
+    alignas(64) int16_t moveHistory[2][64][64];                  // History for [isWhite][from][to]
+    alignas(64) int16_t captureHistory[64][64][PieceType::KING]; // indexed as [from][to][victimPieceType-1]
+    alignas(64) int16_t continuationHistory[CONTINUATION_HISTORY_SIZE][6][64][6][64];
 
-    MoveSorter(const Board& board, MoveList* mlist, Move best) : size(mlist->GetSize())
+    SearchHistory()
     {
-        for (unsigned int i = 0; i < size; i++)
-        {
-            if (mlist->moves[i] == best)
-                moveVals[i] = {best, PV_BONUS};
-            else
-            {
-                if (mlist->moves[i].isType<CAPTURE>())
-                    moveVals[i] = ScoreMoveQ(board, mlist->moves[i]);
-                else
-                    moveVals[i] = ScoreMove(board, mlist->moves[i]);
-            }
-        }
+        Clear();
     }
 
-    ~MoveSorter() = default;
-    Move Next()
+    void Clear()
     {
-        int bestIndex = 0;
-        int bestScore = moveVals[0].score;
-
-        for (unsigned int i = 1; i < size; i++)
-        {
-            if (moveVals[i].score > bestScore)
-            {
-                bestScore = moveVals[i].score;
-                bestIndex = i;
-            }
-        }
+        std::memset(static_cast<void*>(this), 0, sizeof(SearchHistory));
+    }
 
-        MoveVal bestMove = moveVals[bestIndex];
+    void ClearKillers()
+    {
+        std::memset(static_cast<void*>(killerMoves), 0, sizeof(killerMoves));
+    }
 
-        // Swap the best move with the end list
-        moveVals[bestIndex] = moveVals[--size];
-        moveVals[size] = bestMove;
+    inline void addKillerMove(unsigned char ply, Move m)
+    {
+        if (killerMoves[ply][0] == m)
+            return;
 
-        return bestMove.m;
+        killerMoves[ply][1] = killerMoves[ply][0];
+        killerMoves[ply][0] = m;
     }
-};
 
-extern Move killerMoves[MAX_PLY][2];                    // each ply can have two killer moves
-extern int16_t moveHistory[2][64][64];                  // History for [isWhite][from][to]
-extern int16_t captureHistory[64][64][PieceType::KING]; // same as moveHistory
-extern Move counterMove[64][64];
-extern int16_t continuationHistory[CONTINUATION_HISTORY_SIZE][6][64][6][64];
+    inline void updateContinuationHistory(Board& board, Move m, int depth, bool negate)
+    {
+        int negative = negate ? -1 : 1;
+        const BoardState* prevState = board.getState();
+        PieceType moved = getType(board.getSQ(m.from()));
+        int clampedBonus = std::clamp(depth * depth, -MAX_HISTORY, MAX_HISTORY) * negative;
+        for (int i = 0; i < CONTINUATION_HISTORY_SIZE; i++)
+        {
+            if (!prevState || prevState->moved == EMPTY)
+                break;
 
-inline void addKillerMove(unsigned char ply, Move m)
-{
-    if (killerMoves[ply][0] == m)
-        return;
+            PieceType pType = getType(prevState->moved);
+            Move prevMove = prevState->move;
+            continuationHistory[i][pType - 1][prevMove.to()][moved - 1][m.to()] +=
+                clampedBonus - continuationHistory[i][pType - 1][prevMove.to()][moved - 1][m.to()] *
+                                   std::abs(clampedBonus) / MAX_HISTORY;
 
-    killerMoves[ply][1] = killerMoves[ply][0];
-    killerMoves[ply][0] = m;
-}
+            prevState = prevState->prev;
+        }
+    }
 
-inline void updateContinuationHistory(Board& board, Move m, int depth, bool negate)
-{
-    int negative = negate ? -1 : 1;
-    const BoardState* prevState = board.getState();
-    PieceType moved = getType(board.getSQ(m.from()));
-    int clampedBonus = std::clamp(depth * depth, -MAX_HISTORY, MAX_HISTORY) * negative;
-    for (int i = 0; i < CONTINUATION_HISTORY_SIZE; i++)
+    inline void addHistoryBonus(bool isWhite, Move m, int depth)
+    {
+        int clampedBonus = std::clamp(depth * depth * depth, -MAX_HISTORY, MAX_HISTORY);
+        moveHistory[isWhite][m.from()][m.to()] +=
+            clampedBonus - moveHistory[isWhite][m.from()][m.to()] * std::abs(clampedBonus) / MAX_HISTORY;
+    }
+
+    inline void addHistoryPenalty(bool isWhite, Move m, int depth)
     {
-        if (!prevState || prevState->moved == EMPTY)
-            break;
+        const int penalty = std::clamp(depth * depth * depth, -MAX_HISTORY, MAX_HISTORY);
+        auto gravity = moveHistory[isWhite][m.from()][m.to()] * std::abs(penalty) / MAX_HISTORY;
+        moveHistory[isWhite][m.from()][m.to()] -= penalty + gravity;
+    }
 
-        PieceType pType = getType(prevState->moved);
-        Move prevMove = prevState->move;
-        continuationHistory[i][pType - 1][prevMove.to()][moved - 1][m.to()] +=
+    inline void addCaptureBonus(PieceType victimType, Move m, int depth)
+    {
+        int clampedBonus = std::clamp(depth * depth * depth, -MAX_CAPTURE_HISTORY, MAX_CAPTURE_HISTORY);
+        captureHistory[m.from()][m.to()][victimType - 1] +=
             clampedBonus -
-            continuationHistory[i][pType - 1][prevMove.to()][moved - 1][m.to()] * std::abs(clampedBonus) / MAX_HISTORY;
+            captureHistory[m.from()][m.to()][victimType - 1] * std::abs(clampedBonus) / MAX_CAPTURE_HISTORY;
+    }
 
-        prevState = prevState->prev;
+    inline void addCapturePenalty(PieceType victimType, Move m, int depth)
+    {
+        const int penalty = std::clamp(depth * depth * depth, -MAX_CAPTURE_HISTORY, MAX_CAPTURE_HISTORY);
+        captureHistory[m.from()][m.to()][victimType - 1] -=
+            penalty + captureHistory[m.from()][m.to()][victimType - 1] * std::abs(penalty) / MAX_CAPTURE_HISTORY;
     }
-}
+};
 
-inline void addHistoryBonus(bool isWhite, Move m, int depth)
-{
-    int clampedBonus = std::clamp(depth * depth * depth, -MAX_HISTORY, MAX_HISTORY);
-    moveHistory[isWhite][m.from()][m.to()] +=
-        clampedBonus - moveHistory[isWhite][m.from()][m.to()] * std::abs(clampedBonus) / MAX_HISTORY;
-}
+MoveVal ScoreMove(const Board& board, const SearchHistory& history, Move m);
+MoveVal ScoreMoveQ(const Board& board, const SearchHistory& history, Move m);
 
-inline void addHistoryPenalty(bool isWhite, Move m, int depth)
+enum PickerStage
 {
-    const int penalty = std::clamp(depth * depth * depth, -MAX_HISTORY, MAX_HISTORY);
-    auto gravity = moveHistory[isWhite][m.from()][m.to()] * std::abs(penalty) / MAX_HISTORY;
-    moveHistory[isWhite][m.from()][m.to()] -= penalty + gravity;
-}
+    // main search
+    STAGE_TT_MOVE,
+    STAGE_GEN_CAPTURES,
+    STAGE_GOOD_CAPTURES,
+    STAGE_KILLER_1,
+    STAGE_KILLER_2,
+    STAGE_COUNTER_MOVE,
+    STAGE_GEN_QUIETS,
+    STAGE_QUIETS,
+    STAGE_BAD_CAPTURES,
+
+    // in check
+    STAGE_EVASION_TT_MOVE,
+    STAGE_GEN_EVASIONS,
+    STAGE_EVASIONS,
+
+    // quiescence search
+    STAGE_QS_TT_MOVE,
+    STAGE_GEN_QS_CAPTURES,
+    STAGE_QS_CAPTURES,
+
+    STAGE_DONE
+};
 
-inline void addCaptureBonus(PieceType victimType, Move m, int depth)
+/**
+ * @brief Hands out the legal moves of a position one at a time, in stages, so work is only done for the moves that
+ * are actually searched. The TT move is tried before any move is generated, then captures/promotions are generated
+ * and scored, then killers and the counter move, and only then are the quiet moves generated and scored. Captures
+ * that lose material (by static exchange evaluation) are deferred until after the quiets.
+ * @paragraph
+ * When in check all evasions are generated and scored at once. In quiescence search only the TT move (if it's a
+ * capture or promotion) and the captures/promotions are returned.
+ */
+class MovePicker
 {
-    int clampedBonus = std::clamp(depth * depth * depth, -MAX_CAPTURE_HISTORY, MAX_CAPTURE_HISTORY);
-    captureHistory[m.from()][m.to()][victimType - 1] +=
-        clampedBonus - captureHistory[m.from()][m.to()][victimType - 1] * std::abs(clampedBonus) / MAX_CAPTURE_HISTORY;
-}
+  public:
+    MovePicker(Board& board, const SearchHistory& history, Move ttMove, SortType type);
 
-inline void addCapturePenalty(PieceType victimType, Move m, int depth)
-{
-    const int penalty = std::clamp(depth * depth * depth, -MAX_CAPTURE_HISTORY, MAX_CAPTURE_HISTORY);
-    captureHistory[m.from()][m.to()][victimType - 1] -=
-        penalty + captureHistory[m.from()][m.to()][victimType - 1] * std::abs(penalty) / MAX_CAPTURE_HISTORY;
-}
+    /**
+     * @brief Gets the next move to search
+     *
+     * @return Move the next move, a null move (0) when there are no moves left
+     */
+    Move Next();
+
+  private:
+    // selects the best scored move in [cur, end) and moves it to cur
+    MoveVal PickBest();
+
+    // checks if a killer/counter move can be played here and hasn't been returned already
+    bool IsUsableQuiet(Move m) const;
+
+    // generates moves of the given type and scores them into moveVals starting at end
+    template <MoveType type>
+    void GenerateAndScore();
+
+    Board& board;
+    const SearchHistory& history;
+
+    Move ttMove;
+    Move killers[2];
+    Move counterMove;
+
+    int stage;
+
+    MoveVal moveVals[256];
+    MoveVal* cur;
+    MoveVal* end;
+    MoveVal* badCapturesEnd; // bad captures are moved to the start of moveVals
+};
 
 inline Score Mvv_Lva_Score(const Board& board, Move m)
 {
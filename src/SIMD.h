@@ -3,8 +3,18 @@
 
 #include <immintrin.h>
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+// The kernels are compiled once per instruction set tier (see nnue/kernels.cpp), each copy of these functions lives in
+// the tier's own namespace so the copies compiled with different instruction sets are never merged by the linker
+#ifndef SIMD_NAMESPACE
+#error "SIMD.h must only be included by the per-tier kernels, with SIMD_NAMESPACE defined"
+#endif
 
 namespace SIMD
+{
+inline namespace SIMD_NAMESPACE
 {
 
 
@@ -12,6 +22,9 @@ namespace SIMD
 
         using vec_t = __m512i;
 
+        // number of registers used to hold a tile of the accumulator (of the 32 available)
+        constexpr int NUM_TILE_REGS = 16;
+
         inline vec_t loadVec(const int8_t* ptr)
         {
             return _mm512_loadu_si512(reinterpret_cast<const vec_t*>(ptr));
@@ -26,7 +39,8 @@ namespace SIMD
         {
             vec_t pack = _mm512_packs_epi16(v, w);
             const __m512i idx = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
-            return _mm512_permutexvar_epi64(idx, pack);
+            // maskz with a full mask is the same permutation, the unmasked intrinsic trips -Wuninitialized in GCC 12
+            return _mm512_maskz_permutexvar_epi64(0xFF, idx, pack);
         }
 
         inline vec_t vecMaddubs16(const vec_t& a, const vec_t& b)
@@ -74,6 +88,22 @@ namespace SIMD
             return _mm512_add_epi16(a, b);
         }
 
+        inline vec_t vecSub16(const vec_t& a, const vec_t& b)
+        {
+            return _mm512_sub_epi16(a, b);
+        }
+
+        inline vec_t vecBroadcast32(int32_t num)
+        {
+            return _mm512_set1_epi32(num);
+        }
+
+        // bit i is set if 32 bit lane i is not zero
+        inline uint64_t vecNonZeroMask32(const vec_t& v)
+        {
+            return _mm512_test_epi32_mask(v, v);
+        }
+
         inline vec_t vecMul16(const vec_t& a, const vec_t& b)
         {
             return _mm512_mullo_epi16(a, b);
@@ -108,6 +138,9 @@ namespace SIMD
 
         using vec_t = __m256i;
 
+        // number of registers used to hold a tile of the accumulator (of the 16 available)
+        constexpr int NUM_TILE_REGS = 8;
+
         inline vec_t loadVec(const int8_t* ptr)
         {
             return _mm256_loadu_si256(reinterpret_cast<const vec_t*>(ptr));
@@ -169,6 +202,23 @@ namespace SIMD
             return _mm256_add_epi16(a, b);
         }
 
+        inline vec_t vecSub16(const vec_t& a, const vec_t& b)
+        {
+            return _mm256_sub_epi16(a, b);
+        }
+
+        inline vec_t vecBroadcast32(int32_t num)
+        {
+            return _mm256_set1_epi32(num);
+        }
+
+        // bit i is set if 32 bit lane i is not zero
+        inline uint64_t vecNonZeroMask32(const vec_t& v)
+        {
+            vec_t isZero = _mm256_cmpeq_epi32(v, _mm256_setzero_si256());
+            return ~_mm256_movemask_ps(_mm256_castsi256_ps(isZero)) & 0xFF;
+        }
+
         inline vec_t vecMul16(const vec_t& a, const vec_t& b)
         {
             return _mm256_mullo_epi16(a, b);
@@ -207,6 +257,9 @@ namespace SIMD
     #else
         using vec_t = __m128i;
 
+        // number of registers used to hold a tile of the accumulator (of the 16 available)
+        constexpr int NUM_TILE_REGS = 8;
+
         inline vec_t loadVec(const int8_t* ptr)
         {
             return _mm_loadu_si128(reinterpret_cast<const vec_t*>(ptr));
@@ -267,6 +320,23 @@ namespace SIMD
             return _mm_add_epi16(a, b);
         }
 
+        inline vec_t vecSub16(const vec_t& a, const vec_t& b)
+        {
+            return _mm_sub_epi16(a, b);
+        }
+
+        inline vec_t vecBroadcast32(int32_t num)
+        {
+            return _mm_set1_epi32(num);
+        }
+
+        // bit i is set if 32 bit lane i is not zero
+        inline uint64_t vecNonZeroMask32(const vec_t& v)
+        {
+            vec_t isZero = _mm_cmpeq_epi32(v, _mm_setzero_si128());
+            return ~_mm_movemask_ps(_mm_castsi128_ps(isZero)) & 0xF;
+        }
+
         inline vec_t vecMul16(const vec_t& a, const vec_t& b)
         {
             return _mm_mullo_epi16(a, b);
@@ -314,6 +384,129 @@ namespace SIMD
         return vecReduceAdd(sum);
     }
 
+    // Computes dst = src + adds[0] + adds[1] + ... - subs[0] - subs[1] - ... for n 16 bit values. The values are
+    // processed in tiles of NUM_TILE_REGS registers: each tile of src is loaded once, every row is applied to it while it
+    // stays in registers and it is stored once, so applying several rows costs a single pass over src and dst.
+    // src and dst may point to the same array. n must be a multiple of the tile size
+    inline void addSubRows16(const int16_t* src, int16_t* dst, const int16_t* const* adds, int numAdds,
+                             const int16_t* const* subs, int numSubs, int n)
+    {
+        constexpr int W = sizeof(vec_t) / sizeof(int16_t);
+        constexpr int TILE_SIZE = W * NUM_TILE_REGS;
+
+        assert(n % TILE_SIZE == 0);
+
+        vec_t regs[NUM_TILE_REGS];
+
+        for (int tile = 0; tile < n; tile += TILE_SIZE)
+        {
+            for (int r = 0; r < NUM_TILE_REGS; r++)
+                regs[r] = loadVec(reinterpret_cast<const int8_t*>(src + tile + r * W));
+
+            for (int a = 0; a < numAdds; a++)
+            {
+                const int16_t* row = adds[a] + tile;
+                for (int r = 0; r < NUM_TILE_REGS; r++)
+                    regs[r] = vecAdd16(regs[r], loadVec(reinterpret_cast<const int8_t*>(row + r * W)));
+            }
+
+            for (int b = 0; b < numSubs; b++)
+            {
+                const int16_t* row = subs[b] + tile;
+                for (int r = 0; r < NUM_TILE_REGS; r++)
+                    regs[r] = vecSub16(regs[r], loadVec(reinterpret_cast<const int8_t*>(row + r * W)));
+            }
+
+            for (int r = 0; r < NUM_TILE_REGS; r++)
+                storeVec(reinterpret_cast<int8_t*>(dst + tile + r * W), regs[r]);
+        }
+    }
+
+    // Dot product of short arrays of unsigned bytes a and signed bytes b, n a multiple of 16. Uses 128 bit vectors so
+    // it works for arrays smaller than a full vector
+    inline int32_t dotProduct8Short(const int8_t* a, const int8_t* b, int n)
+    {
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < n; i += 16)
+        {
+            __m128i vecA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vecB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(vecA, vecB), _mm_set1_epi16(1)));
+        }
+        sum = _mm_add_epi32(sum, _mm_unpackhi_epi64(sum, sum));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(sum);
+    }
+
+    // Adds the dot products of each group of 4 unsigned bytes of a with the 4 signed bytes of b to the 32 bit lanes of
+    // acc. Pairs of products are summed in 16 bits, which can't saturate as long as a is at most 127
+    inline vec_t vecDpbusd32(const vec_t& acc, const vec_t& a, const vec_t& b)
+    {
+    #if defined(__AVX512BW__) && defined(__AVX512VNNI__)
+        return _mm512_dpbusd_epi32(acc, a, b);
+    #elif !defined(__AVX512BW__) && defined(__AVX2__) && defined(__AVXVNNI__)
+        return _mm256_dpbusd_avx_epi32(acc, a, b);
+    #else
+        return vecAdd32(acc, vecAddAdjacents16(vecMaddubs16(a, b)));
+    #endif
+    }
+
+    // NON_ZERO_OFFSETS[mask] holds the positions of the set bits of an 8 bit mask, in order
+    struct NonZeroOffsets
+    {
+        alignas(16) uint16_t offsets[256][8];
+
+        constexpr NonZeroOffsets() : offsets{}
+        {
+            for (int mask = 0; mask < 256; mask++)
+            {
+                int count = 0;
+                for (int bit = 0; bit < 8; bit++)
+                    if (mask & (1 << bit))
+                        offsets[mask][count++] = bit;
+            }
+        }
+    };
+
+    inline constexpr NonZeroOffsets NON_ZERO_OFFSETS{};
+
+    // Writes the indexes of the non-zero 4 byte chunks of input (n bytes) to indexes and returns how many there are.
+    // The lanes are tested a vector at a time and the resulting masks are turned into indexes 8 at a time with a lookup
+    // table, so there is no branch per chunk. indexes must have room for n / 4 + 8 values. n must be a multiple of 256
+    inline int findNonZeroChunks(const int8_t* input, int n, uint16_t* indexes)
+    {
+        constexpr int BLOCK_SIZE = 256; // bytes covered by one 64 bit mask
+        constexpr int CHUNKS_PER_VEC = sizeof(vec_t) / 4;
+
+        assert(n % BLOCK_SIZE == 0);
+
+        int count = 0;
+        __m128i base = _mm_setzero_si128();
+        const __m128i eight = _mm_set1_epi16(8);
+
+        for (int block = 0; block < n; block += BLOCK_SIZE)
+        {
+            uint64_t mask = 0;
+            for (int i = 0; i < BLOCK_SIZE; i += sizeof(vec_t))
+            {
+                uint64_t vecMask = vecNonZeroMask32(loadVec(input + block + i));
+                mask |= vecMask << (i / sizeof(vec_t) * CHUNKS_PER_VEC);
+            }
+
+            for (int byte = 0; byte < 8; byte++)
+            {
+                const unsigned bits = (mask >> (byte * 8)) & 0xFF;
+                const __m128i offsets =
+                    _mm_load_si128(reinterpret_cast<const __m128i*>(NON_ZERO_OFFSETS.offsets[bits]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(indexes + count), _mm_add_epi16(base, offsets));
+                count += __builtin_popcount(bits);
+                base = _mm_add_epi16(base, eight);
+            }
+        }
+
+        return count;
+    }
+
     inline void CReLU(const int16_t* input, int8_t* output, int32_t max, int n)
     {
         vec_t maxVec = vecBroadcast16(max);
@@ -359,5 +552,6 @@ namespace SIMD
         }
     }
 }
+} // namespace SIMD_NAMESPACE
 
-#endif
+#endif
\ No newline at end of file
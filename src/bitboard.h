@@ -1,7 +1,10 @@
 #ifndef BITBOARD_H
 #define BITBOARD_H
 
+#include "direction.h"
+#include "square.h"
 #include "types.h"
+#include <array>
 #include <cassert>
 
 constexpr Bitboard emptyBB = 0ULL;
@@ -44,24 +47,6 @@ alignas(64) constexpr Bitboard castleBBs[] = {
 };
 
 // clang-format on
-// Move generation
-
-extern Bitboard knightMoves[64];
-extern Bitboard kingMoves[64];
-extern Bitboard pawnAttacks[9][64];
-extern Bitboard pawnMoves[9][64];
-extern Bitboard rookMasks[64];
-extern Bitboard bishopMasks[64];
-extern Bitboard bitboardPaths[64][64];
-
-extern const Bitboard (*bitboardRays)[64];
-
-// Evaluation
-
-extern Bitboard passedPawnBB[9][64]; // contains masks for finding passed pawns [side][square]
-extern Bitboard isolatedPawnBB[64];  // contains masks for finding isloated pawns [square]
-extern Bitboard pawnShield[2][8];    // contains masks for calculating shielded pawns [isBlack][square]
-
 // Bitboard operations
 
 constexpr Bitboard sqrToBB(const Square sq)
@@ -69,22 +54,22 @@ constexpr Bitboard sqrToBB(const Square sq)
     return 1ULL << sq;
 }
 
-inline void setBit(Bitboard& bb, const Square sq)
+constexpr void setBit(Bitboard& bb, const Square sq)
 {
     bb |= 1ULL << sq;
 }
 
-inline void clearBit(Bitboard& bb, const Square sq)
+constexpr void clearBit(Bitboard& bb, const Square sq)
 {
     bb &= ~(1ULL << sq);
 }
 
-inline void toggleBit(Bitboard& bb, const Square sq)
+constexpr void toggleBit(Bitboard& bb, const Square sq)
 {
     bb ^= 1ULL << sq;
 }
 
-inline bool getBit(const Bitboard bb, const Square sq)
+constexpr bool getBit(const Bitboard bb, const Square sq)
 {
     return bb & (1ULL << sq);
 }
@@ -101,7 +86,7 @@ constexpr Square lsb(const Bitboard bb)
 #endif
 }
 
-inline Square msb(const Bitboard bb)
+constexpr Square msb(const Bitboard bb)
 {
     assert(bb != 0);
 #if _MSC_VER
@@ -113,7 +98,7 @@ inline Square msb(const Bitboard bb)
 #endif
 }
 
-inline Square popLSB(Bitboard& bb)
+constexpr Square popLSB(Bitboard& bb)
 {
     Square bit = lsb(bb);
     bb &= bb - 1;
@@ -129,6 +114,214 @@ constexpr int popCount(const Bitboard bb)
 #endif
 }
 
+// Move generation
+
+alignas(64) inline constexpr auto knightMoves = [] {
+    constexpr Direction knightDirs[] = {NORTH + NORTH + EAST, NORTH + NORTH + WEST, SOUTH + SOUTH + EAST,
+                                        SOUTH + SOUTH + WEST, EAST + EAST + NORTH,  EAST + EAST + SOUTH,
+                                        WEST + WEST + NORTH,  WEST + WEST + SOUTH};
+
+    // commonly uses manhattan distance to check for board wraps
+    std::array<Bitboard, 64> table{};
+    for (Square sqr = SQ_A1; sqr <= SQ_H8; sqr++)
+    {
+        for (Direction dir : knightDirs)
+        {
+            Square to = sqr + dir;
+            if (to >= 0 && to < 64 && manhattanDistance(sqr, to) == 3)
+                setBit(table[sqr], to);
+        }
+    }
+    return table;
+}();
+
+alignas(64) inline constexpr auto kingMoves = [] {
+    constexpr Direction kingDirs[] = {NORTH, SOUTH, EAST, WEST, NORTH_EAST, NORTH_WEST, SOUTH_EAST, SOUTH_WEST};
+
+    std::array<Bitboard, 64> table{};
+    for (Square sqr = SQ_A1; sqr <= SQ_H8; sqr++)
+    {
+        for (Direction dir : kingDirs)
+        {
+            Square to = sqr + dir;
+            if (to >= 0 && to < 64 && manhattanDistance(sqr, to) == 1)
+                setBit(table[sqr], to);
+            if (to >= 0 && to < 64 && manhattanDistance(sqr, to) == 2)
+                setBit(table[sqr], to);
+        }
+    }
+    return table;
+}();
+
+alignas(64) inline constexpr auto pawnAttacks = [] {
+    constexpr Direction pawnWAttackDirs[] = {NORTH_EAST, NORTH_WEST};
+    constexpr Direction pawnBAttackDirs[] = {SOUTH_EAST, SOUTH_WEST};
+
+    std::array<std::array<Bitboard, 64>, 9> table{}; // [color][square]
+    for (Square sqr = SQ_A1; sqr <= SQ_H8; sqr++)
+    {
+        for (Direction dir : pawnWAttackDirs)
+        {
+            Square to = sqr + dir;
+            if (to >= 0 && to < 64 && manhattanDistance(sqr, to) == 2)
+                setBit(table[WHITE][sqr], to);
+        }
+
+        for (Direction dir : pawnBAttackDirs)
+        {
+            Square to = sqr + dir;
+            if (to >= 0 && to < 64 && manhattanDistance(sqr, to) == 2)
+                setBit(table[BLACK][sqr], to);
+        }
+    }
+    return table;
+}();
+
+alignas(64) inline constexpr auto pawnMoves = [] {
+    std::array<std::array<Bitboard, 64>, 9> table{}; // [color][square]
+    for (Square sqr = SQ_A1; sqr <= SQ_H8; sqr++)
+    {
+        Square to = sqr + NORTH;
+        if (to >= 0 && to < 64)
+            setBit(table[WHITE][sqr], to);
+
+        to = sqr + SOUTH;
+        if (to >= 0 && to < 64)
+            setBit(table[BLACK][sqr], to);
+
+        // Double pawn moves
+        if (getRank(sqr) == 1)
+            setBit(table[WHITE][sqr], sqr + NORTH + NORTH);
+
+        if (getRank(sqr) == 6)
+            setBit(table[BLACK][sqr], sqr + SOUTH + SOUTH);
+    }
+    return table;
+}();
+
+// bitboards with bits starting from a certain square heading off the board (start square isn't included)
+alignas(64) inline constexpr auto bitboardRayTable = [] {
+    std::array<std::array<Bitboard, 64>, 19> table{}; // [direction + 9][square]
+    for (Square sqr = SQ_A1; sqr <= SQ_H8; sqr++)
+    {
+        for (Direction dir = SOUTH_WEST; dir <= NORTH_EAST; dir++)
+        {
+            Square i = sqr;
+            while (dir && distToEdge[dir][i] != 0)
+            {
+                i += dir;
+                setBit(table[dir + 9][sqr], i);
+            }
+        }
+    }
+    return table;
+}();
+
+// offset pointer to the array so negative directions can be used as an index
+inline constexpr const std::array<Bitboard, 64>* bitboardRays = bitboardRayTable.data() + 9;
+
+// bitboards with bits from one square to another (note that the start squares/first index isn't included)
+alignas(64) inline constexpr auto bitboardPaths = [] {
+    std::array<std::array<Bitboard, 64>, 64> table{};
+    for (Square sqr = SQ_A1; sqr <= SQ_H8; sqr++)
+    {
+        for (Square sqr2 = SQ_A1; sqr2 <= SQ_H8; sqr2++)
+        {
+            Direction dir = directionsTable[sqr][sqr2];
+            if (dir != NONE_DIR)
+            {
+                Square i = sqr;
+                while (i != sqr2)
+                {
+                    i += dir;
+                    setBit(table[sqr][sqr2], i);
+                }
+            }
+        }
+    }
+    return table;
+}();
+
+alignas(64) inline constexpr auto rookMasks = [] {
+    std::array<Bitboard, 64> table{};
+    for (Square sqr = SQ_A1; sqr <= SQ_H8; sqr++)
+        table[sqr] =
+            bitboardRays[NORTH][sqr] | bitboardRays[SOUTH][sqr] | bitboardRays[EAST][sqr] | bitboardRays[WEST][sqr];
+    return table;
+}();
+
+alignas(64) inline constexpr auto bishopMasks = [] {
+    std::array<Bitboard, 64> table{};
+    for (Square sqr = SQ_A1; sqr <= SQ_H8; sqr++)
+        table[sqr] = bitboardRays[SOUTH_WEST][sqr] | bitboardRays[SOUTH_EAST][sqr] | bitboardRays[NORTH_EAST][sqr] |
+                     bitboardRays[NORTH_WEST][sqr];
+    return table;
+}();
+
+// Evaluation
+
+// contains masks for finding passed pawns [side][square]
+alignas(64) inline constexpr auto passedPawnBB = [] {
+    std::array<std::array<Bitboard, 64>, 9> table{};
+    for (Square sqr = SQ_A1; sqr <= SQ_H8; sqr++)
+    {
+        Rank rank = getRank(sqr);
+        File file = getFile(sqr);
+        const Bitboard files = fileBBs[file] | fileBBs[file == FILE_A ? file : file - 1] |
+                               fileBBs[file == FILE_H ? file : file + 1];
+        if (rank != RANK_1 && rank != RANK_8)
+        {
+            table[WHITE][sqr] = shift(files, NORTH * (rank + 1));
+            table[BLACK][sqr] = shift(files, SOUTH * (8 - rank));
+        }
+    }
+    return table;
+}();
+
+// contains masks for finding isloated pawns [square]
+alignas(64) inline constexpr auto isolatedPawnBB = [] {
+    std::array<Bitboard, 64> table{};
+    for (Square sqr = SQ_A1; sqr <= SQ_H8; sqr++)
+    {
+        File file = getFile(sqr);
+        const Bitboard left = fileBBs[file == FILE_A ? file : file - 1];
+        const Bitboard right = fileBBs[file == FILE_H ? file : file + 1];
+        table[sqr] = (left | right) & ~fileBBs[file];
+    }
+    return table;
+}();
+
+// contains masks for calculating shielded pawns [isBlack][file]
+alignas(64) inline constexpr auto pawnShield = [] {
+    std::array<std::array<Bitboard, 8>, 2> table{};
+    for (File file = FILE_A; file <= FILE_H; file++)
+    {
+        if (file == FILE_A)
+        {
+            table[0][file] = sqrToBB(SQ_A2) | sqrToBB(SQ_B2) | sqrToBB(SQ_A3) | sqrToBB(SQ_B3);
+            table[1][file] = sqrToBB(SQ_A7) | sqrToBB(SQ_B7) | sqrToBB(SQ_A6) | sqrToBB(SQ_B6);
+        }
+        else if (file == FILE_H)
+        {
+            table[0][file] = sqrToBB(SQ_H2) | sqrToBB(SQ_G2) | sqrToBB(SQ_H3) | sqrToBB(SQ_G3);
+            table[1][file] = sqrToBB(SQ_H7) | sqrToBB(SQ_G7) | sqrToBB(SQ_H6) | sqrToBB(SQ_G6);
+        }
+        else
+        {
+            Bitboard king = sqrToBB(getSquare(file, RANK_1));
+
+            Bitboard straight = shift(king, NORTH_EAST) | shift(king, NORTH_WEST) | shift(king, NORTH);
+            straight |= shift(straight, NORTH);
+
+            table[0][file] = straight;
+
+            straight = shift(straight, NORTH * 4); // rank 2/3 -> rank 6/7
+            table[1][file] = straight;
+        }
+    }
+    return table;
+}();
+
 constexpr Bitboard operator>>(const Bitboard b, const Direction d)
 {
     if (d < 0)
@@ -137,6 +330,5 @@ constexpr Bitboard operator>>(const Bitboard b, const Direction d)
 }
 
 extern Bitboard sendRay(Square i, const Direction dir, const Bitboard blockers);
-extern void initBBs();
 
 #endif
\ No newline at end of file
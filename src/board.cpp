@@ -20,6 +20,8 @@ BoardState::BoardState()
     this->attacks[0] = 0ULL;
     this->attacks[1] = 0ULL;
 
+    hasCheckInfo = false;
+
     move = 0;
     castling = NONE_CASTLE;
     enPassantSquare = SQ_NONE;
@@ -48,6 +50,7 @@ BoardState::BoardState(BoardState* prev)
     this->move50rule = prev->move50rule + 1;
 
     this->repetition = 1;
+    this->hasCheckInfo = false;
     this->prev = prev;
 }
 
@@ -139,6 +142,7 @@ void Board::makeMove(Move move, BoardState* newState, DirtyMove& dirtyMove)
     newState->attacks[0] = 0ULL;
     newState->attacks[1] = 0ULL;
     newState->checkers = 0;
+    newState->hasCheckInfo = false;
     newState->repetition = 0;
     newState->enPassantSquare = SQ_NONE; //* note: only set if en passant can be played
 
@@ -319,7 +323,6 @@ void Board::makeMove(Move move, BoardState* newState, DirtyMove& dirtyMove)
 
     // fill dirty move here after move has been made (because promotion/en_passant)
 
-    computeAttackedBBs();
     if (whiteToMove)
         state->checkers = getAttackers<BLACK>(lsb(getBB(WHITE, KING)));
     else
@@ -427,6 +430,7 @@ void Board::makeNullMove(BoardState* newState)
 
     state->zobristHash ^= isBlackHash;
 
+    state->hasCheckInfo = false; // the side to move changed
     state->repetition = getRepetition();
 }
 
@@ -595,17 +599,20 @@ void Board::setFen(const std::string& fen, BoardState* newState)
     if (noActionRule50 != "-")
         state->move50rule = std::atoi(noActionRule50.c_str());
 
-    computeAttackedBBs();
     if (whiteToMove)
         state->checkers = getAttackers<BLACK>(lsb(getBB(WHITE, KING)));
     else
         state->checkers = getAttackers<WHITE>(lsb(getBB(BLACK, KING)));
 }
 
-void Board::ResetWhiteAccumulator(Accumulator& whiteAcc) const
+void Board::ResetWhiteAccumulator(const NNUE& network, Accumulator& whiteAcc) const
 {
-    nnue->Reset(whiteAcc);
+    network.Reset(whiteAcc);
     Square whiteKingSquare = lsb(pieceBB[KING] & colorBB[WHITE]);
+
+    // gather all the pieces and add them in a single pass over the accumulator
+    int indexes[MAX_UPDATE_FEATURES];
+    int numIndexes = 0;
     for (PieceType i = PAWN; i < ALL_PIECES; i = static_cast<PieceType>(i + 1))
     {
         Bitboard bb = pieceBB[i];
@@ -613,16 +620,20 @@ void Board::ResetWhiteAccumulator(Accumulator& whiteAcc) const
         {
             Square sqr = popLSB(bb);
             Piece piece = board[sqr];
-            int whiteIndex = GetIndex(sqr, whiteKingSquare, piece, true);
-            nnue->Add(whiteAcc, whiteIndex);
+            indexes[numIndexes++] = GetIndex(sqr, whiteKingSquare, piece, true);
         }
     }
+    network.Update(whiteAcc, whiteAcc, indexes, numIndexes, nullptr, 0);
 }
 
-void Board::ResetBlackAccumulator(Accumulator& blackAcc) const
+void Board::ResetBlackAccumulator(const NNUE& network, Accumulator& blackAcc) const
 {
-    nnue->Reset(blackAcc);
+    network.Reset(blackAcc);
     Square blackKingSquare = lsb(pieceBB[KING] & colorBB[BLACK]);
+
+    // gather all the pieces and add them in a single pass over the accumulator
+    int indexes[MAX_UPDATE_FEATURES];
+    int numIndexes = 0;
     for (PieceType i = PAWN; i < ALL_PIECES; i = static_cast<PieceType>(i + 1))
     {
         Bitboard bb = pieceBB[i];
@@ -630,15 +641,15 @@ void Board::ResetBlackAccumulator(Accumulator& blackAcc) const
         {
             Square sqr = popLSB(bb);
             Piece piece = board[sqr];
-            int blackIndex = GetIndex(sqr, blackKingSquare, piece, false);
-            nnue->Add(blackAcc, blackIndex);
+            indexes[numIndexes++] = GetIndex(sqr, blackKingSquare, piece, false);
         }
     }
+    network.Update(blackAcc, blackAcc, indexes, numIndexes, nullptr, 0);
 }
 
-// Updates attacked bitboard and returns number of checks of the opposing king
+// Generates the bitboard of all squares attacked by a side, the enemy king doesn't block
 template <Color side>
-void Board::generateAttackBB()
+Bitboard Board::generateAttackBB() const
 {
     PROFILE_FUNC();
     constexpr Direction forward = side == WHITE ? NORTH : SOUTH;
@@ -681,9 +692,12 @@ void Board::generateAttackBB()
     Square king = lsb(getBB(side, KING));
     attackBB |= kingMoves[king];
 
-    state->attacks[side == BLACK] = attackBB;
+    return attackBB;
 }
 
+template Bitboard Board::generateAttackBB<WHITE>() const;
+template Bitboard Board::generateAttackBB<BLACK>() const;
+
 template <Color side>
 Bitboard Board::getAttackers(const Square sqr) const
 {
@@ -708,15 +722,23 @@ Bitboard Board::getAttackers(const Square sqr) const
 }
 
 bool Board::isAttacked(const Square sqr, const Color byColor) const
+{
+    return isAttacked(sqr, byColor, getBB(ALL_PIECES));
+}
+
+bool Board::isAttacked(const Square sqr, const Color byColor, const Bitboard occupied) const
 {
     if (pawnAttacks[~byColor][sqr] & getBB(byColor, PAWN))
         return true;
     if (knightMoves[sqr] & getBB(byColor, KNIGHT))
         return true;
 
-    if (GetRookMoves(getBB(ALL_PIECES), sqr) & (getBB(byColor, ROOK, QUEEN)))
+    // skip the slider lookups when no slider is on one of the square's lines
+    const Bitboard straight = getBB(byColor, ROOK, QUEEN);
+    if ((rookMasks[sqr] & straight) && (GetRookMoves(occupied, sqr) & straight))
         return true;
-    if (GetBishopMoves(getBB(ALL_PIECES), sqr) & (getBB(byColor, BISHOP, QUEEN)))
+    const Bitboard diagonal = getBB(byColor, BISHOP, QUEEN);
+    if ((bishopMasks[sqr] & diagonal) && (GetBishopMoves(occupied, sqr) & diagonal))
         return true;
 
     if (kingMoves[sqr] & getBB(byColor, KING))
@@ -725,26 +747,7 @@ bool Board::isAttacked(const Square sqr, const Color byColor) const
     return false;
 }
 
-// computes the attacked bitboards for boths sides and returns the check bitboard
-void Board::computeAttackedBBs()
-{
-    if (whiteToMove)
-    {
-        generateAttackBB<BLACK>();
-#ifndef PERFT
-        generateAttackBB<WHITE>();
-#endif
-    }
-    else
-    {
-        generateAttackBB<WHITE>();
-#ifndef PERFT
-        generateAttackBB<BLACK>();
-#endif
-    }
-}
-
-void Board::computePins(Bitboard& pinnedS, Bitboard& pinnedD)
+void Board::computePins(Bitboard& pinnedS, Bitboard& pinnedD) const
 {
     pinnedS = pinnedD = 0ULL;
 
@@ -772,99 +775,342 @@ void Board::computePins(Bitboard& pinnedS, Bitboard& pinnedD)
     }
 }
 
-bool Board::isCheckMove(Move move)
+void Board::computeCheckInfo() const
 {
-    const Piece piece =
-        (move.type() == PROMOTION) ? makePiece(move.promotion(), getColor(getSQ(move.from()))) : getSQ(move.from());
-    const Color side = getColor(piece);
-    const PieceType pType = getType(piece);
+    computePins(state->pinnedS, state->pinnedD);
+
+    const Color us = sideToMove;
+    const Square enemyKing = lsb(getBB(~us, KING));
+    const Bitboard occupied = getBB(ALL_PIECES);
+
+    state->checkSquares[EMPTY] = 0ULL;
+    state->checkSquares[PAWN] = pawnAttacks[~us][enemyKing];
+    state->checkSquares[KNIGHT] = knightMoves[enemyKing];
+    state->checkSquares[BISHOP] = GetBishopMoves(occupied, enemyKing);
+    state->checkSquares[ROOK] = GetRookMoves(occupied, enemyKing);
+    state->checkSquares[QUEEN] = state->checkSquares[BISHOP] | state->checkSquares[ROOK];
+    state->checkSquares[KING] = 0ULL;
+
+    // our sliders aimed at the enemy king with exactly one piece in between, if that piece is ours it can uncover check
+    Bitboard snipers =
+        (rookMasks[enemyKing] & getBB(us, ROOK, QUEEN)) | (bishopMasks[enemyKing] & getBB(us, BISHOP, QUEEN));
+
+    state->discoveredCheckers = 0ULL;
+    while (snipers)
+    {
+        const Square sniper = popLSB(snipers);
+        const Bitboard between = bitboardPaths[enemyKing][sniper] & occupied & ~sqrToBB(sniper);
+        if (popCount(between) == 1)
+            state->discoveredCheckers |= between & getBB(us);
+    }
+
+    // only set once everything above is filled in
+    state->hasCheckInfo = true;
+}
+
+bool Board::isPseudoLegal(Move move) const
+{
+    const Square from = move.from();
     const Square to = move.to();
+    const Bitboard toBB = sqrToBB(to);
+    const Piece piece = getSQ(from);
+    const Color us = sideToMove;
+
+    if (!move.getMove() || piece == EMPTY || getColor(piece) != us || (getBB(us) & toBB))
+        return false;
+
+    const PieceType pType = getType(piece);
+    const Bitboard occupied = getBB(ALL_PIECES);
+    const Bitboard enemy = getBB(~us);
+
+    if (move.type() == CASTLE)
+    {
+        if (pType != KING || getCheckers())
+            return false;
+
+        const CastlingRights castleRights = state->castling;
+        const CastlingRights shortCastle = us == WHITE ? CASTLE_WK : CASTLE_BK;
+        const CastlingRights longCastle = us == WHITE ? CASTLE_WQ : CASTLE_BQ;
+        const Square kingSquare = us == WHITE ? SQ_E1 : SQ_E8;
+
+        CastlingRights right;
+        if (move == Move(kingSquare, kingSquare + 2, CASTLE, EMPTY))
+            right = shortCastle;
+        else if (move == Move(kingSquare, kingSquare - 2, CASTLE, EMPTY) && !(occupied & sqrToBB(kingSquare - 3)))
+            right = longCastle;
+        else
+            return false;
+
+        if (!(castleRights & right) || (occupied & castleBBs[right]))
+            return false;
 
-    const Bitboard enemyKing = getBB(~side, KING);
-    Bitboard blockers = getBB(ALL_PIECES);
+        Bitboard path = castleBBs[right];
+        while (path)
+        {
+            if (isAttacked(popLSB(path), ~us))
+                return false;
+        }
+        return true;
+    }
+
+    // only promotions use the promotion bits
+    if (move.type() != PROMOTION && move.promotion() != KNIGHT)
+        return false;
 
-    const Direction dir = directionsTable[to][lsb(enemyKing)];
-    // check for direct checks
+    const bool isCapture = toBB & enemy;
 
-    switch (pType)
+    if (pType == PAWN)
     {
-    case PAWN:
-        if (pawnAttacks[side][to] & enemyKing)
-            return true;
-        break;
-    case KNIGHT:
-        if (knightMoves[to] & enemyKing)
-            return true;
-        break;
-    case BISHOP:
-        if ((dir == SOUTH_EAST || dir == SOUTH_WEST || dir == NORTH_WEST ||
-             dir == NORTH_EAST) && // if diagonal and no blockers in the way
-            !(bitboardPaths[to][lsb(enemyKing)] & blockers & ~enemyKing))
-            return true;
-        break;
-    case ROOK:
-        if ((dir == SOUTH || dir == WEST || dir == NORTH || dir == EAST) && // if straight and no blockers in the way
-            !(bitboardPaths[to][lsb(enemyKing)] & blockers & ~enemyKing))
-            return true;
-        break;
-    case QUEEN:
-        if (dir && !(bitboardPaths[to][lsb(enemyKing)] & blockers &
-                     ~enemyKing)) // if there's a direction and no blockers in the way
-            return true;
-        break;
-    case KING:
-        if (move.type() == CASTLE) // look for checks from the rook during castling
-        {
-            const Square rookPos = (move.from() + move.to()) >> 1;
-            const Direction rookDir = directionsTable[rookPos][lsb(enemyKing)];
-
-            if (!rookDir) // if there is no direction from where the rook is
+        const Direction forward = us == WHITE ? NORTH : SOUTH;
+        const Bitboard lastRank = us == WHITE ? rankBBs[RANK_8] : rankBBs[RANK_1];
+
+        if ((move.type() == PROMOTION) != bool(toBB & lastRank))
+            return false;
+
+        if (pawnAttacks[us][from] & toBB)
+        {
+            if (!isCapture && (to != getEnPassantSqr() || move.type() != CAPTURE))
+                return false;
+            if (isCapture && move.type() == QUIET)
+                return false;
+        }
+        else
+        {
+            if ((toBB & occupied) || move.type() == CAPTURE)
                 return false;
 
-            Bitboard ray = GetRookMoves(blockers, rookPos);
-            if (ray & enemyKing)
-                return true;
+            const bool singlePush = to == from + forward;
+            const bool doublePush = to == from + forward * 2 && !(occupied & sqrToBB(from + forward)) &&
+                                    (sqrToBB(from) & (us == WHITE ? rankBBs[RANK_2] : rankBBs[RANK_7]));
+            if (!singlePush && !doublePush)
+                return false;
         }
-        break;
-    default:
-        break;
     }
+    else
+    {
+        if (move.type() == PROMOTION || (move.type() == CAPTURE) != isCapture)
+            return false;
 
-    // check for revealed checks
+        Bitboard moves;
+        switch (pType)
+        {
+        case KNIGHT:
+            moves = knightMoves[from];
+            break;
+        case BISHOP:
+            moves = GetBishopMoves(occupied, from);
+            break;
+        case ROOK:
+            moves = GetRookMoves(occupied, from);
+            break;
+        case QUEEN:
+            moves = GetBishopMoves(occupied, from) | GetRookMoves(occupied, from);
+            break;
+        default:
+            moves = kingMoves[from];
+            break;
+        }
 
-    const Direction fromDir = directionsTable[move.from()][lsb(enemyKing)];
+        if (!(moves & toBB))
+            return false;
+    }
 
-    if (!fromDir) // if there is no direction from where the piece was
-        return false;
+    // when in check, anything but a king move has to capture the checker or block the check
+    const Bitboard checkers = getCheckers();
+    if (checkers && pType != KING)
+    {
+        if (popCount(checkers) > 1)
+            return false;
 
-    setBit(blockers, to);
-    clearBit(blockers, move.from());
+        const Square king = lsb(getBB(us, KING));
+        const Bitboard checkBB = (checkers & getBB(KNIGHT)) ? checkers : bitboardPaths[king][lsb(checkers)];
+        const bool capturesCheckerEnPassant =
+            pType == PAWN && to == getEnPassantSqr() && (shift(checkBB, us == WHITE ? NORTH : SOUTH) & toBB);
 
-    if (move.to() == getEnPassantSqr() && getType(getSQ(move.from())) == PAWN)
-        clearBit(blockers, move.to() - (side == WHITE ? NORTH : SOUTH));
+        if (!(checkBB & toBB) && !capturesCheckerEnPassant)
+            return false;
+    }
 
-    if (bitboardPaths[move.from()][lsb(enemyKing)] & blockers &
-        ~enemyKing) // if there are blockers between the from square and the king
-        return false;
+    return true;
+}
 
-    Bitboard ray = (GetBishopMoves(blockers, move.from()) | GetRookMoves(blockers, move.from())) &
-                   bitboardRays[-fromDir][move.from()] & getBB(side);
-    if (!ray)
+bool Board::isLegal(Move move) const
+{
+    const Square from = move.from();
+    const Square to = move.to();
+    const Color us = sideToMove;
+
+    if (getType(getSQ(from)) == KING) // castling squares are checked in isPseudoLegal
+        return move.type() == CASTLE || !isAttacked(to, ~us, getBB(ALL_PIECES) ^ sqrToBB(from));
+
+    const Square king = lsb(getBB(us, KING));
+    const bool enPassant = getType(getSQ(from)) == PAWN && to == getEnPassantSqr();
+
+    // only a piece in line with the king can be pinned
+    if (!enPassant && directionsTable[king][from] == NONE_DIR)
+        return true;
+
+    Bitboard occupied = (getBB(ALL_PIECES) ^ sqrToBB(from)) | sqrToBB(to);
+    Bitboard captured = sqrToBB(to);
+    if (enPassant)
+    {
+        const Square capturedPawn = to - (us == WHITE ? NORTH : SOUTH);
+        occupied ^= sqrToBB(capturedPawn);
+        captured = sqrToBB(capturedPawn);
+    }
+
+    const Bitboard diagonal = getBB(~us, BISHOP, QUEEN) & ~captured;
+    const Bitboard straight = getBB(~us, ROOK, QUEEN) & ~captured;
+
+    return !(GetBishopMoves(occupied, king) & diagonal) && !(GetRookMoves(occupied, king) & straight);
+}
+
+Bitboard Board::getAllAttackers(const Square sqr, const Bitboard occupied) const
+{
+    return (GetBishopMoves(occupied, sqr) & getBB(BISHOP, QUEEN)) | (GetRookMoves(occupied, sqr) & getBB(ROOK, QUEEN)) |
+           (knightMoves[sqr] & getBB(KNIGHT)) | (kingMoves[sqr] & getBB(KING)) |
+           (pawnAttacks[BLACK][sqr] & getBB(WHITE, PAWN)) | (pawnAttacks[WHITE][sqr] & getBB(BLACK, PAWN));
+}
+
+bool Board::see(Move move, Score threshold) const
+{
+    if (move.type() == CASTLE || move.type() == PROMOTION)
+        return 0 >= threshold;
+
+    const Square from = move.from();
+    const Square to = move.to();
+    const bool enPassant = move.type() == CAPTURE && getSQ(to) == EMPTY;
+
+    // swap is what the side to move gains if the exchange stops here, relative to the threshold
+    Score swap = pieceScores[enPassant ? PAWN : getType(getSQ(to))] - threshold;
+    if (swap < 0)
         return false;
 
-    PieceType attacker = getType(board[lsb(ray)]);
+    swap = pieceScores[getType(getSQ(from))] - swap;
+    if (swap <= 0)
+        return true;
+
+    Bitboard occupied = getBB(ALL_PIECES) ^ sqrToBB(from) ^ sqrToBB(to);
+    if (enPassant)
+        occupied ^= sqrToBB(to - (sideToMove == WHITE ? NORTH : SOUTH));
+
+    const Bitboard diagonal = getBB(BISHOP, QUEEN);
+    const Bitboard straight = getBB(ROOK, QUEEN);
 
-    switch (attacker)
+    Color stm = sideToMove;
+    Bitboard attackers = getAllAttackers(to, occupied);
+    bool result = true;
+
+    while (true)
     {
-    case BISHOP:
-        return fromDir == SOUTH_EAST || fromDir == SOUTH_WEST || fromDir == NORTH_WEST || fromDir == NORTH_EAST;
-    case ROOK:
-        return fromDir == EAST || fromDir == WEST || fromDir == NORTH || fromDir == SOUTH;
-    case QUEEN:
+        stm = ~stm;
+        attackers &= occupied;
+
+        Bitboard stmAttackers = attackers & getBB(stm);
+        if (!stmAttackers)
+            break;
+
+        result = !result;
+
+        // capture with the least valuable attacker, then add the attackers behind it
+        Bitboard bb;
+        if ((bb = stmAttackers & getBB(PAWN)))
+        {
+            if ((swap = pieceScores[PAWN] - swap) < result)
+                break;
+            occupied ^= sqrToBB(lsb(bb));
+            attackers |= GetBishopMoves(occupied, to) & diagonal;
+        }
+        else if ((bb = stmAttackers & getBB(KNIGHT)))
+        {
+            if ((swap = pieceScores[KNIGHT] - swap) < result)
+                break;
+            occupied ^= sqrToBB(lsb(bb));
+        }
+        else if ((bb = stmAttackers & getBB(BISHOP)))
+        {
+            if ((swap = pieceScores[BISHOP] - swap) < result)
+                break;
+            occupied ^= sqrToBB(lsb(bb));
+            attackers |= GetBishopMoves(occupied, to) & diagonal;
+        }
+        else if ((bb = stmAttackers & getBB(ROOK)))
+        {
+            if ((swap = pieceScores[ROOK] - swap) < result)
+                break;
+            occupied ^= sqrToBB(lsb(bb));
+            attackers |= GetRookMoves(occupied, to) & straight;
+        }
+        else if ((bb = stmAttackers & getBB(QUEEN)))
+        {
+            if ((swap = pieceScores[QUEEN] - swap) < result)
+                break;
+            occupied ^= sqrToBB(lsb(bb));
+            attackers |= (GetBishopMoves(occupied, to) & diagonal) | (GetRookMoves(occupied, to) & straight);
+        }
+        else // king, it can only capture if the other side has no attackers left
+            return (attackers & ~getBB(stm)) ? !result : result;
+    }
+
+    return result;
+}
+
+bool Board::isCheckMove(Move move) const
+{
+    const Square from = move.from();
+    const Square to = move.to();
+    const Color us = sideToMove;
+    const PieceType pType = getType(getSQ(from));
+    const Square enemyKing = lsb(getBB(~us, KING));
+    const BoardState* info = getCheckInfo();
+
+    // direct checks, a promotion is handled below since the pawn itself could block the new piece
+    if (move.type() != PROMOTION && (info->checkSquares[pType] & sqrToBB(to)))
         return true;
-    default:
-        return false;
+
+    // a discovered check unless the piece stays on the line to the king
+    if ((info->discoveredCheckers & sqrToBB(from)) &&
+        (move.type() == CASTLE || directionsTable[enemyKing][from] != directionsTable[enemyKing][to]))
+        return true;
+
+    const Bitboard occupied = getBB(ALL_PIECES) ^ sqrToBB(from);
+
+    if (move.type() == PROMOTION)
+    {
+        switch (move.promotion())
+        {
+        case KNIGHT:
+            return knightMoves[to] & getBB(~us, KING);
+        case BISHOP:
+            return GetBishopMoves(occupied, to) & getBB(~us, KING);
+        case ROOK:
+            return GetRookMoves(occupied, to) & getBB(~us, KING);
+        default:
+            return (GetBishopMoves(occupied, to) | GetRookMoves(occupied, to)) & getBB(~us, KING);
+        }
+    }
+
+    // removing the captured pawn can open a line to the king
+    if (pType == PAWN && to == getEnPassantSqr())
+    {
+        const Square captured = to - (us == WHITE ? NORTH : SOUTH);
+        const Bitboard after = (occupied ^ sqrToBB(captured)) | sqrToBB(to);
+
+        return (GetBishopMoves(after, enemyKing) & getBB(us, BISHOP, QUEEN)) |
+               (GetRookMoves(after, enemyKing) & getBB(us, ROOK, QUEEN));
     }
+
+    // the rook jumps over the king, to the square the king crossed
+    if (move.type() == CASTLE)
+    {
+        const Square rookFrom = to > from ? to + 1 : to - 2;
+        const Square rookTo = (from + to) >> 1;
+        const Bitboard after = (occupied ^ sqrToBB(rookFrom)) | sqrToBB(to) | sqrToBB(rookTo);
+
+        return GetRookMoves(after, rookTo) & getBB(~us, KING);
+    }
+
+    return false;
 }
 
 std::string Board::getFen() const
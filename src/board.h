@@ -20,8 +20,16 @@ struct BoardState
 {
     BoardState* prev;
 
-    Bitboard attacks[2]; // the attacks a side has (white = 0 black = 1)
+    Bitboard attacks[2]; // the attacks a side has (white = 0 black = 1), 0 until first asked for
     Bitboard checkers;
+
+    // filled in by Board::computeCheckInfo the first time the move generator or isCheckMove needs them
+    bool hasCheckInfo;
+    Bitboard pinnedS;                // straight pin rays on the side to move, from its king up to the pinning piece
+    Bitboard pinnedD;                // diagonal pin rays on the side to move
+    Bitboard checkSquares[KING + 1]; // squares a piece type of the side to move gives check from
+    Bitboard discoveredCheckers;     // pieces of the side to move that give check by leaving the line to the king
+
     Key zobristHash;
     Piece captured;
     Piece moved;
@@ -68,19 +76,48 @@ class Board
     }
 
     /**
-     * @brief checks if a move causes check
+     * @brief checks if a move causes check, using the check squares and discovered checkers of the position
+     *
+     * @param move a legal move
+     * @return bool
+     */
+    bool isCheckMove(Move move) const;
+
+    /**
+     * @brief checks if a move could be generated in this position ignoring pins (the moving piece belongs to the side
+     * to move, it can reach the target square and the move type matches). Used to validate moves that didn't come
+     * from the move generator (TT move, killers, counter moves)
      *
      * @param move move to check
      * @return bool
      */
-    bool isCheckMove(Move move);
+    bool isPseudoLegal(Move move) const;
+
+    /**
+     * @brief checks if a pseudo legal move doesn't leave the king in check
+     *
+     * @param move a move for which isPseudoLegal is true
+     * @return bool
+     */
+    bool isLegal(Move move) const;
+
+    /**
+     * @brief Static exchange evaluation, checks if the sequence of captures on the target square of a move wins at
+     * least threshold material for the side to move (both sides always recapture with their least valuable piece,
+     * including attackers x-raying through the pieces that captured before them)
+     *
+     * @param move move to check
+     * @param threshold the minimum material gain
+     * @return bool
+     */
+    bool see(Move move, Score threshold) const;
 
     void print() const;
 
     void setFen(const std::string& fen, BoardState* newState);
 
-    void ResetWhiteAccumulator(Accumulator& whiteAcc) const;
-    void ResetBlackAccumulator(Accumulator& blackAcc) const;
+    void ResetWhiteAccumulator(const NNUE& network, Accumulator& whiteAcc) const;
+    void ResetBlackAccumulator(const NNUE& network, Accumulator& blackAcc) const;
 
     std::string getFen() const;
 
@@ -88,14 +125,33 @@ class Board
     void clear();
 
     template <Color side>
-    void generateAttackBB();
-    void computeAttackedBBs();
+    Bitboard generateAttackBB() const;
 
     template <Color side>
     Bitboard getAttackers(const Square sqr) const;
+
+    // gets the pieces of both colors attacking a square with the given occupancy
+    Bitboard getAllAttackers(const Square sqr, const Bitboard occupied) const;
     bool isAttacked(const Square sqr, const Color byColor) const;
+    bool isAttacked(const Square sqr, const Color byColor, const Bitboard occupied) const;
+
+    void computePins(Bitboard& pinnedS, Bitboard& pinnedD) const;
+
+    // fills in the pins, check squares and discovered checkers of the current state
+    void computeCheckInfo() const;
 
-    void computePins(Bitboard& pinnedS, Bitboard& pinnedD);
+    /**
+     * @brief Gets the current state with its pins, check squares and discovered checkers filled in. They are computed
+     * once per position, on the first call
+     *
+     * @return const BoardState*
+     */
+    inline const BoardState* getCheckInfo() const
+    {
+        if (!state->hasCheckInfo)
+            computeCheckInfo();
+        return state;
+    }
 
     // Get bitboards
 
@@ -138,14 +194,18 @@ class Board
     }
 
     /**
-     * @brief Returns the bitboard of attacked squared by the specified color
+     * @brief Returns the bitboard of attacked squared by the specified color. Most nodes never need it, so it is only
+     * generated on the first call and cached in the board state (a side always attacks something, its king does)
      *
      * @param c color
      * @return Bitboard
      */
     inline Bitboard getAttacked(const Color c) const
     {
-        return state->attacks[c == BLACK];
+        Bitboard& attacks = state->attacks[c == BLACK];
+        if (!attacks)
+            attacks = c == WHITE ? generateAttackBB<WHITE>() : generateAttackBB<BLACK>();
+        return attacks;
     }
 
     /**
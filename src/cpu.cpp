@@ -0,0 +1,76 @@
+#include "cpu.h"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+
+// XCR0 bits for the register state the OS saves: SSE | AVX and, for AVX-512, opmask | ZMM0-15 upper | ZMM16-31
+#define XCR0_YMM_STATE 0x6
+#define XCR0_ZMM_STATE 0xE6
+
+static uint64_t ReadXcr0()
+{
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (uint64_t(edx) << 32) | eax;
+}
+
+static CpuFeatures DetectCpuFeatures()
+{
+    CpuFeatures features;
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx))
+        return features;
+
+    // "AuthenticAMD" or "HygonGenuine" in ebx, edx, ecx. Hygon's Dhyana is a Zen 1 licensed from AMD (family 18h)
+    const bool amd = (ebx == 0x68747541 && edx == 0x69746e65 && ecx == 0x444d4163) ||
+                     (ebx == 0x6f677948 && edx == 0x6e65476e && ecx == 0x656e6975);
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return features;
+
+    unsigned int family = (eax >> 8) & 0xf;
+    if (family == 0xf)
+        family += (eax >> 20) & 0xff;
+
+    features.popcnt = ecx & bit_POPCNT;
+    features.sse41 = ecx & bit_SSE4_1;
+
+    const bool avx = ecx & bit_AVX;
+    const uint64_t xcr0 = (ecx & bit_OSXSAVE) ? ReadXcr0() : 0;
+    const bool ymmState = avx && (xcr0 & XCR0_YMM_STATE) == XCR0_YMM_STATE;
+    const bool zmmState = ymmState && (xcr0 & XCR0_ZMM_STATE) == XCR0_ZMM_STATE;
+
+    features.fma = ymmState && (ecx & bit_FMA);
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return features;
+
+    features.avx2 = ymmState && (ebx & bit_AVX2);
+    features.bmi1 = ebx & bit_BMI;
+    features.bmi2 = ebx & bit_BMI2;
+    features.slowPext = features.bmi2 && amd && family < 0x19; // Zen 3 is family 19h
+    features.avx512f = zmmState && (ebx & bit_AVX512F);
+    features.avx512bw = zmmState && (ebx & bit_AVX512BW);
+    features.avx512dq = zmmState && (ebx & bit_AVX512DQ);
+    features.avx512vl = zmmState && (ebx & bit_AVX512VL);
+    features.avx512vnni = zmmState && (ecx & bit_AVX512VNNI);
+
+    return features;
+}
+
+#else
+
+static CpuFeatures DetectCpuFeatures()
+{
+    return CpuFeatures();
+}
+
+#endif
+
+const CpuFeatures& GetCpuFeatures()
+{
+    static const CpuFeatures features = DetectCpuFeatures();
+    return features;
+}
@@ -0,0 +1,31 @@
+#ifndef CPU_H
+#define CPU_H
+
+/**
+ * @brief The instruction set extensions of the CPU the engine runs on. An extension that needs OS support for its
+ * registers (AVX, AVX-512) is only reported if the OS saves them on context switches
+ */
+struct CpuFeatures
+{
+    bool popcnt = false;
+    bool sse41 = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool bmi1 = false;
+    bool bmi2 = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool avx512dq = false;
+    bool avx512vl = false;
+    bool avx512vnni = false;
+    bool slowPext = false; // PEXT/PDEP are microcoded (AMD before Zen 3, Hygon)
+};
+
+/**
+ * @brief Gets the features of this CPU, detected with cpuid on first use
+ *
+ * @return const CpuFeatures&
+ */
+const CpuFeatures& GetCpuFeatures();
+
+#endif
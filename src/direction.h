@@ -1,13 +1,11 @@
 #ifndef DIRECTION_H
 #define DIRECTION_H
 
+#include "square.h"
 #include "types.h"
+#include <array>
 #include <cmath>
 
-// Precompute stuff
-
-extern Direction directionsTable[64][64];
-
 // Buncha operators
 
 constexpr Direction operator+(Direction a, Direction b)
@@ -112,6 +110,60 @@ constexpr Bitboard shift(Bitboard d, Direction dir)
         return d << dir;
 }
 
-extern void initDirection();
+// Precompute stuff
+
+// the direction from the first square to the second, NONE_DIR if they aren't on the same line
+alignas(64) inline constexpr auto directionsTable = [] {
+    std::array<std::array<Direction, 64>, 64> table{};
+
+    for (Square first = SQ_A1; first <= SQ_H8; first++)
+    {
+        for (Square second = SQ_A1; second <= SQ_H8; second++)
+        {
+            File firstFile = getFile(first);
+            Rank firstRank = getRank(first);
+
+            File secondFile = getFile(second);
+            Rank secondRank = getRank(second);
+
+            if (first == second)
+                table[first][second] = NONE_DIR;
+            else if (firstRank == secondRank)
+            {
+                if (firstFile > secondFile)
+                    table[first][second] = WEST;
+                else
+                    table[first][second] = EAST;
+            }
+            else if (firstFile == secondFile)
+            {
+                if (firstRank > secondRank)
+                    table[first][second] = SOUTH;
+                else
+                    table[first][second] = NORTH;
+            }
+            else if (firstFile - secondFile == firstRank - secondRank)
+            {
+                if (firstRank > secondRank)
+                    table[first][second] = SOUTH_WEST;
+                else
+                    table[first][second] = NORTH_EAST;
+            }
+            else if (firstFile - secondFile == secondRank - firstRank)
+            {
+                if (firstRank > secondRank)
+                    table[first][second] = SOUTH_EAST;
+                else
+                    table[first][second] = NORTH_WEST;
+            }
+            else
+            {
+                table[first][second] = NONE_DIR;
+            }
+        }
+    }
+
+    return table;
+}();
 
 #endif
\ No newline at end of file
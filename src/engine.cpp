@@ -1,5 +1,8 @@
+#include <algorithm>
 #include <chrono>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 
 #include "MoveSort.h"
 #include "direction.h"
@@ -7,6 +10,10 @@
 #include "evaluate.h"
 #include "move.h"
 #include "movegen.h"
+#include "largeAlloc.h"
+#include "magic.h"
+#include "nnue/embeddedNet.h"
+#include "nnue/kernels.h"
 #include "nnue/nnue.h"
 #include "perft.h"
 #include "platform.h"
@@ -15,30 +22,50 @@
 #include "time.h"
 #include "transposition.h"
 #include <cstring>
+#include <mutex>
 
-Engine::Engine()
+/**
+ * @brief Loads the default network: the one embedded in the executable, or the file in nnue_bin next to the executable
+ * if there is none
+ *
+ * @return std::shared_ptr<const NNUE> nullptr on failure
+ */
+static std::shared_ptr<const NNUE> LoadDefaultNetwork()
 {
-    initSquare();
-    initDirection();
-    initBBs();
-    InitZobrist();
-    InitMagics();
-
-    std::memset(moveHistory, 0, sizeof(moveHistory));
+    if (std::shared_ptr<const NNUE> network = NNUE::LoadEmbedded())
+        return network;
 
     std::string exeDir;
     GetExecutablePath(exeDir);
     exeDir = exeDir.substr(0, exeDir.find_last_of("/\\"));
-    bool nnueLoaded = nnue->Load(exeDir + "/nnue_bin/nnue02.bin");
-    if (!nnueLoaded)
+    return NNUE::LoadShared(exeDir + "/nnue_bin/" + DefaultEvalFile());
+}
+
+Engine::Engine(std::shared_ptr<const NNUE> network) : network(std::move(network)), threads(1)
+{
+    // the lookup tables are process wide, only initialize them for the first engine
+    static std::once_flag initFlag;
+    std::call_once(initFlag, [] {
+        InitMagics();
+        InitKernels();
+
+        std::cout << "info string CPU: " << ActiveKernels().name << " NNUE kernels, "
+                  << SliderBackendName(sliderBackend) << " sliders" << std::endl;
+    });
+
+    if (!this->network)
+        this->network = LoadDefaultNetwork();
+
+    if (!this->network)
     {
-        std::cerr << "Failed to load NNUE network." << std::endl;
+        std::cerr << "Error: no network could be loaded, evaluating with zeroed weights." << std::endl;
+        this->network = MakeSharedLarge<NNUE>();
     }
 
     board = new Board;
     board->setFen(START_FEN, &states[0]);
 
-    searcher = new Searcher;
+    searcher = new Searcher(this->network);
 }
 
 Engine::~Engine()
@@ -47,6 +74,22 @@ Engine::~Engine()
     delete searcher;
 }
 
+void Engine::setEvalFile(const std::string& filename)
+{
+    std::shared_ptr<const NNUE> newNetwork =
+        filename.empty() || filename == DefaultEvalFile() ? LoadDefaultNetwork() : NNUE::LoadShared(filename);
+
+    if (!newNetwork)
+    {
+        std::cout << "info string EvalFile " << filename << " could not be loaded, keeping the current network"
+                  << std::endl;
+        return;
+    }
+
+    network = std::move(newNetwork);
+    searcher->SetNetwork(network);
+}
+
 void Engine::makemove(Move move)
 {
     MoveList legal;
@@ -65,7 +108,8 @@ void Engine::makemove(Move move)
     }
 }
 
-void Engine::go(unsigned int depth, unsigned int nodes, unsigned int movetime, unsigned int wtime, unsigned int btime)
+void Engine::go(unsigned int depth, unsigned int nodes, unsigned int movetime, unsigned int wtime, unsigned int btime,
+                unsigned int winc, unsigned int binc, unsigned int movestogo, bool ponder)
 {
     unsigned int remaining_time = board->whiteToMove ? wtime : btime;
     SearchConstraints constraints;
@@ -73,6 +117,9 @@ void Engine::go(unsigned int depth, unsigned int nodes, unsigned int movetime, u
     constraints.maxNodes = nodes;
     constraints.movetime = movetime;
     constraints.remainingTime = remaining_time;
+    constraints.increment = board->whiteToMove ? winc : binc;
+    constraints.movesToGo = movestogo;
+    constraints.ponder = ponder;
     searcher->StartSearch(*board, constraints);
 }
 
@@ -84,38 +131,120 @@ void Engine::stop()
 void Engine::goPerft(unsigned int depth)
 {
     unsigned long long start = getTime();
-    unsigned long long moveCount = 0;
 
-    MoveList moves;
-    board->generateMoves<ALL_MOVES>(&moves);
-    BoardState state;
-    DirtyMove dirtyMove;
+    // the table is kept between runs, its counts don't go stale
+    std::vector<std::pair<Move, unsigned long long>> divide;
+    unsigned long long moveCount = PerftDivide(*board, depth, threads, perftTable.get(), &divide);
 
-    for (Move* mPtr = moves.moves; mPtr < moves.end; mPtr++)
+    for (auto& [move, count] : divide)
+        std::cout << move.toString() << ": " << count << "\n";
+
+    unsigned long long end = getTime();
+    std::cout << "Total Moves: " << moveCount << " Took: " << (end - start) << " ms" << std::endl;
+}
+
+void Engine::setPerftHash(unsigned long long megabytes)
+{
+    perftTable.reset(megabytes ? new PerftTable(megabytes) : nullptr);
+
+    if (perftTable && !perftTable->IsAllocated())
     {
-        Move move = *mPtr;
-        board->makeMove(move, &state, dirtyMove);
-        unsigned long long count = perft(*board, depth - 1);
-        board->undoMove();
+        perftTable.reset();
+        std::cout << "info string Failed to allocate " << megabytes << " MB for the perft table, running without it"
+                  << std::endl;
+    }
+}
 
-        moveCount += count;
+void Engine::perftSuite(const std::string& filename, unsigned int maxDepth)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cout << "info string " << filename << " could not be opened" << std::endl;
+        return;
+    }
 
-        std::cout << move.toString() << ": " << count << "\n";
+    unsigned long long start = getTime();
+    unsigned long long totalNodes = 0;
+    int numPositions = 0;
+    int numPassed = 0; // positions with at least one checked depth, all of them matching
+    int numFailed = 0;
+    int numUnchecked = 0; // positions without a depth to check
+    int numChecks = 0; // checked depths over all positions
+    int numFailedChecks = 0;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        const size_t fenEnd = line.find(';');
+        if (fenEnd == std::string::npos)
+            continue;
+
+        numPositions++;
+        const std::string fen = line.substr(0, line.find_last_not_of(' ', fenEnd - 1) + 1);
+        BoardState state;
+        Board position;
+        position.setFen(fen, &state);
+        std::cout << "position " << numPositions << " " << fen << std::endl;
+
+        // ;D<depth> <count> for every depth, the suite's own order is kept
+        std::stringstream expected(line.substr(fenEnd));
+        std::string depthField;
+        unsigned long long expectedCount;
+        bool passed = true;
+        bool checked = false;
+        while (expected >> depthField >> expectedCount)
+        {
+            if (depthField.size() < 3 || depthField.compare(0, 2, ";D") != 0)
+                continue;
+
+            const unsigned int depth = atoi(depthField.c_str() + 2);
+            if (maxDepth && depth > maxDepth)
+                continue;
+
+            const unsigned long long count = PerftDivide(position, depth, threads, perftTable.get());
+            totalNodes += count;
+            numChecks++;
+            checked = true;
+
+            std::cout << "  depth " << depth << " nodes " << count;
+            if (count == expectedCount)
+                std::cout << " ok" << std::endl;
+            else
+            {
+                passed = false;
+                numFailedChecks++;
+                std::cout << " FAIL expected " << expectedCount << std::endl;
+            }
+        }
+
+        if (!checked)
+        {
+            numUnchecked++;
+            std::cout << "  no depth to check" << std::endl;
+        }
+        else if (passed)
+            numPassed++;
+        else
+            numFailed++;
     }
 
     unsigned long long end = getTime();
-    std::cout << "Total Moves: " << moveCount << " Took: " << (end - start) << " ms" << std::endl;
+    std::cout << "Positions: " << numPositions << " Passed: " << numPassed << " Failed: " << numFailed
+              << " Unchecked: " << numUnchecked << "\nDepth checks: " << numChecks << " Passed: " << numChecks - numFailedChecks
+              << " Failed: " << numFailedChecks << "\nNodes: " << totalNodes << " Took: " << (end - start) << " ms ("
+              << totalNodes / 1000 / std::max(end - start, 1ULL) << " Mnps)" << std::endl;
 }
 
 void Engine::eval()
 {
     Accumulator white, black;
-    board->ResetWhiteAccumulator(white);
-    board->ResetBlackAccumulator(black);
+    board->ResetWhiteAccumulator(*network, white);
+    board->ResetBlackAccumulator(*network, black);
     Accumulator& us = board->whiteToMove ? white : black;
     Accumulator& them = board->whiteToMove ? black : white;
-    float score = nnue->Evaluate(*board, us, them) * (board->whiteToMove ? 1.0f : -1.0f);
-    float psqt = nnue->FastEvaluate(*board, us, them) * (board->whiteToMove ? 1.0f : -1.0f);
+    Score score = network->Evaluate(*board, us, them) * (board->whiteToMove ? 1 : -1);
+    Score psqt = network->FastEvaluate(*board, us, them) * (board->whiteToMove ? 1 : -1);
 
     for (Rank r = RANK_8; r >= RANK_1; r = (Rank)(r - 1))
     {
@@ -140,10 +269,10 @@ void Engine::eval()
             {
                 board->removePiece(s);
 
-                board->ResetWhiteAccumulator(white);
-                board->ResetBlackAccumulator(black);
-                float newScore = nnue->Evaluate(*board, us, them) * (board->whiteToMove ? 1.0f : -1.0f);
-                pieceVal = (score - newScore) / 100;
+                board->ResetWhiteAccumulator(*network, white);
+                board->ResetBlackAccumulator(*network, black);
+                Score newScore = network->Evaluate(*board, us, them) * (board->whiteToMove ? 1 : -1);
+                pieceVal = (score - newScore) / 100.0f;
 
                 board->addPiece(p, s);
             }
@@ -173,6 +302,40 @@ void Engine::eval()
     std::cout << "Positional: " << score - psqt << "\nPsqt: " << psqt << "\n\nEval: " << score << std::endl;
 }
 
+void Engine::evalFens(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cout << "info string " << filename << " could not be opened" << std::endl;
+        return;
+    }
+
+    std::vector<std::string> fens;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (!line.empty())
+            fens.push_back(line);
+    }
+
+    std::vector<BoardState> states(fens.size());
+    std::vector<Board> boards(fens.size());
+    for (size_t i = 0; i < fens.size(); i++)
+        boards[i].setFen(fens[i], &states[i]);
+
+    std::vector<Score> scores(fens.size());
+    unsigned long long start = getTime();
+    network->EvaluateBatch(boards.data(), boards.size(), scores.data());
+    unsigned long long end = getTime();
+
+    for (size_t i = 0; i < fens.size(); i++)
+        std::cout << fens[i] << " ; " << scores[i] * (boards[i].whiteToMove ? 1 : -1) << "\n";
+
+    std::cout << "info string evaluated " << fens.size() << " positions in " << (end - start) << " ms ("
+              << fens.size() * 1000 / std::max(end - start, 1ULL) << " positions/s)" << std::endl;
+}
+
 void Engine::isCheck(Move move)
 {
     MoveList legal;
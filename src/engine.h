@@ -2,8 +2,10 @@
 #define ENGINE_H
 
 #include <iostream>
+#include <memory>
 
 #include "board.h"
+#include "perft.h"
 #include "search.h"
 
 /**
@@ -12,7 +14,13 @@
 class Engine
 {
   public:
-    Engine();
+    /**
+     * @brief Construct a new Engine
+     *
+     * @param network the network to evaluate with, several engines can share one. If null, the default network is
+     * used (and shared with every other engine using it): the one embedded in the executable, or the one next to it
+     */
+    Engine(std::shared_ptr<const NNUE> network = nullptr);
     ~Engine();
 
     void print()
@@ -26,13 +34,38 @@ class Engine
         board->setFen(fen, &states[0]);
     }
 
-    void go(unsigned int depth, unsigned int nodes, unsigned int movetime, unsigned int wtime, unsigned int btime);
+    void go(unsigned int depth, unsigned int nodes, unsigned int movetime, unsigned int wtime, unsigned int btime,
+            unsigned int winc, unsigned int binc, unsigned int movestogo, bool ponder);
     void goPerft(unsigned int depth);
 
+    /**
+     * @brief Runs perft on every position of an EPD file, where each line is a FEN followed by the expected counts as
+     * ";D<depth> <count>". Prints the node count of every checked depth, then how many positions and depths passed and
+     * the overall speed. A position passes if all its checked depths match and there is at least one.
+     * tools/perft/standard.epd has the standard positions from the chessprogramming wiki
+     *
+     * @param filename the EPD file
+     * @param maxDepth depths above this are skipped, 0 runs every depth in the file
+     */
+    void perftSuite(const std::string& filename, unsigned int maxDepth);
+
     void stop();
 
+    void ponderhit()
+    {
+        searcher->PonderHit();
+    }
+
     void eval();
 
+    /**
+     * @brief Evaluates every position of a file with one FEN per line through NNUE::EvaluateBatch, printing each score
+     * from white's point of view followed by the throughput
+     *
+     * @param filename
+     */
+    void evalFens(const std::string& filename);
+
     void makemove(Move move);
     void undomove()
     {
@@ -45,9 +78,47 @@ class Engine
         searcher->ClearTT();
     }
 
+    void setThreads(unsigned int threads)
+    {
+        searcher->SetThreads(threads);
+        this->threads = threads;
+    }
+
+    /**
+     * @brief Sets the size of the table perft reuses transposed subtrees from
+     *
+     * @param megabytes the size, 0 disables the table. If no memory can be allocated, perft runs without a table
+     */
+    void setPerftHash(unsigned long long megabytes);
+
+    void setHash(unsigned long long megabytes)
+    {
+        searcher->SetHashSize(megabytes);
+    }
+
+    void setEvalCache(unsigned int kilobytes)
+    {
+        searcher->SetEvalCacheSize(kilobytes);
+    }
+
+    void setLazyEvalMargin(Score margin)
+    {
+        searcher->SetLazyEvalMargin(margin);
+    }
+
+    /**
+     * @brief Switches to the network in a file, the current network is kept if the file can't be loaded
+     *
+     * @param filename the network file, empty or DefaultEvalFile() for the default network
+     */
+    void setEvalFile(const std::string& filename);
+
   private:
+    std::shared_ptr<const NNUE> network;
     Board* board;
     Searcher* searcher;
+    unsigned int threads;                   // search and perft threads
+    std::unique_ptr<PerftTable> perftTable; // nullptr if disabled
     BoardState states[MAX_PLY + 1]; // plus 1 for starting point
 };
 
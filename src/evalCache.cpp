@@ -0,0 +1,36 @@
+#include "evalCache.h"
+
+#include <cstring>
+
+EvalCache::EvalCache(unsigned int kilobytes) : mask(0), hits(0), misses(0)
+{
+    Resize(kilobytes);
+}
+
+void EvalCache::Resize(unsigned int kilobytes)
+{
+    const size_t maxEntries = (size_t)kilobytes * 1024 / sizeof(Entry);
+
+    if (maxEntries < 2)
+    {
+        entries.reset();
+        mask = 0;
+        return;
+    }
+
+    // direct mapped, the slot is the low bits of the hash
+    size_t numEntries = 1;
+    while (numEntries * 2 <= maxEntries)
+        numEntries *= 2;
+
+    entries.reset(new Entry[numEntries]);
+    mask = numEntries - 1;
+    Clear();
+}
+
+void EvalCache::Clear()
+{
+    // an empty slot matches hashes starting with 0xffffffff, no more likely than any other 32 bit collision
+    if (entries)
+        std::memset(entries.get(), 0xff, (mask + 1) * sizeof(Entry));
+}
@@ -0,0 +1,97 @@
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+#include <cstdint>
+#include <memory>
+
+#include "types.h"
+
+#define DEFAULT_EVAL_CACHE_KB 256 // per search thread
+
+/**
+ * @brief A small direct-mapped cache of static evaluations, one per search thread so it needs no synchronization.
+ * Positions reached again through another move order, or re-entered by QSearch, skip the accumulator update and the
+ * network's forward pass. The low bits of the zobrist hash pick the slot and the high 32 bits are kept to verify it
+ */
+class EvalCache
+{
+  public:
+    /**
+     * @brief Construct a new Eval Cache
+     *
+     * @param kilobytes the size, rounded down to a power of two number of entries. 0 disables the cache
+     */
+    EvalCache(unsigned int kilobytes = DEFAULT_EVAL_CACHE_KB);
+
+    /**
+     * @brief Reallocates the cache, all entries are lost
+     *
+     * @param kilobytes the new size, rounded down to a power of two number of entries. 0 disables the cache
+     */
+    void Resize(unsigned int kilobytes);
+
+    void Clear();
+
+    /**
+     * @brief Looks up the evaluation of a position and counts the hit or miss
+     *
+     * @param key zobrist hash of the position
+     * @param eval receives the evaluation if found
+     * @return true if the position was found
+     */
+    inline bool Probe(Key key, Score& eval)
+    {
+        if (!mask)
+            return false;
+
+        const Entry& entry = entries[key & mask];
+        if (entry.check == (uint32_t)(key >> 32))
+        {
+            eval = entry.eval;
+            hits++;
+            return true;
+        }
+
+        misses++;
+        return false;
+    }
+
+    inline void Store(Key key, Score eval)
+    {
+        if (!mask)
+            return;
+
+        entries[key & mask] = {(uint32_t)(key >> 32), eval};
+    }
+
+    inline void ResetStats()
+    {
+        hits = 0;
+        misses = 0;
+    }
+
+    inline unsigned long long GetHits() const
+    {
+        return hits;
+    }
+
+    inline unsigned long long GetMisses() const
+    {
+        return misses;
+    }
+
+  private:
+    struct Entry
+    {
+        uint32_t check; // high 32 bits of the zobrist hash
+        Score eval;
+    };
+
+    std::unique_ptr<Entry[]> entries;
+    Key mask; // number of entries - 1, 0 if disabled
+
+    unsigned long long hits;
+    unsigned long long misses;
+};
+
+#endif
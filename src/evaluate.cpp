@@ -243,7 +243,7 @@ Score Eval<FULL>(Board& board, AccumulatorList& list)
     auto& us = board.whiteToMove ? node.whiteAcc : node.blackAcc;
     auto& them = board.whiteToMove ? node.blackAcc : node.whiteAcc;
 
-    return std::round(nnue->Evaluate(board, us, them));
+    return list.GetNetwork().Evaluate(board, us, them);
 #endif
 }
 
@@ -267,6 +267,6 @@ Score Eval<FAST>(Board& board, AccumulatorList& list)
     auto& us = board.whiteToMove ? node.whiteAcc : node.blackAcc;
     auto& them = board.whiteToMove ? node.blackAcc : node.whiteAcc;
 
-    return std::round(nnue->FastEvaluate(board, us, them));
+    return list.GetNetwork().FastEvaluate(board, us, them);
 #endif
 }
@@ -12,6 +12,13 @@ enum EvalType
     FULL
 };
 
+/**
+ * @brief Evaluates the position from the side to move's perspective
+ *
+ * @param board the position
+ * @param list the accumulators, brought up to date if the network is run
+ * @return Score
+ */
 template <EvalType type>
 Score Eval(Board& board, AccumulatorList& list);
 
@@ -0,0 +1,179 @@
+#include "largeAlloc.h"
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#elif defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define HUGE_PAGE_SIZE (2ULL * 1024 * 1024)
+#define MAX_NUMA_NODES 1024
+
+static size_t RoundUp(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+LargeAllocation LargeAlloc(size_t size)
+{
+    LargeAllocation allocation;
+
+    // large pages need the "Lock pages in memory" privilege, without it the allocation just fails
+    const size_t largePageSize = GetLargePageMinimum();
+    if (largePageSize && size >= largePageSize)
+    {
+        allocation.size = RoundUp(size, largePageSize);
+        allocation.ptr = VirtualAlloc(nullptr, allocation.size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                      PAGE_READWRITE);
+        if (allocation.ptr)
+        {
+            allocation.backing = LargePageBacking::HugeTLB;
+            return allocation;
+        }
+    }
+
+    allocation.size = size;
+    allocation.ptr = VirtualAlloc(nullptr, allocation.size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    allocation.backing = LargePageBacking::Default;
+    return allocation;
+}
+
+void LargeFree(const LargeAllocation& allocation)
+{
+    if (allocation.ptr)
+        VirtualFree(allocation.ptr, 0, MEM_RELEASE);
+}
+
+#elif defined(__linux__)
+
+/**
+ * @brief Reads the online NUMA nodes into a bit mask
+ *
+ * @param mask MAX_NUMA_NODES bits
+ * @return int number of nodes
+ */
+static int GetNumaNodes(unsigned long* mask)
+{
+    constexpr int bitsPerWord = sizeof(unsigned long) * 8;
+
+    std::ifstream file("/sys/devices/system/node/online");
+    std::string list;
+    if (!file || !std::getline(file, list))
+        return 1;
+
+    // format: comma separated list of nodes or ranges, e.g. "0-3,6"
+    int count = 0;
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos)
+            end = list.size();
+
+        const std::string range = list.substr(pos, end - pos);
+        const size_t dash = range.find('-');
+        const int first = atoi(range.c_str());
+        const int last = dash == std::string::npos ? first : atoi(range.c_str() + dash + 1);
+
+        for (int node = first; node <= last && node < MAX_NUMA_NODES; node++)
+        {
+            mask[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+            count++;
+        }
+
+        pos = end + 1;
+    }
+
+    return count ? count : 1;
+}
+
+static bool TransparentHugePagesEnabled()
+{
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string mode;
+    if (!file || !std::getline(file, mode))
+        return false;
+    return mode.find("[never]") == std::string::npos;
+}
+
+LargeAllocation LargeAlloc(size_t size)
+{
+    LargeAllocation allocation;
+    allocation.size = RoundUp(size, HUGE_PAGE_SIZE);
+
+    // explicit huge pages only work if the admin reserved some (vm.nr_hugepages)
+    if (size >= HUGE_PAGE_SIZE)
+    {
+        void* ptr = mmap(nullptr, allocation.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                         -1, 0);
+        if (ptr != MAP_FAILED)
+        {
+            allocation.ptr = ptr;
+            allocation.backing = LargePageBacking::HugeTLB;
+        }
+    }
+
+    if (!allocation.ptr)
+    {
+        // over allocate so the mapping can be trimmed to a 2 MB boundary, the kernel can only use transparent huge
+        // pages for aligned 2 MB ranges
+        const size_t mapSize = allocation.size + HUGE_PAGE_SIZE;
+        void* ptr = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+            return LargeAllocation();
+
+        const uintptr_t start = (uintptr_t)ptr;
+        const uintptr_t aligned = RoundUp(start, HUGE_PAGE_SIZE);
+        if (aligned != start)
+            munmap(ptr, aligned - start);
+        if (const size_t tail = mapSize - (aligned - start) - allocation.size)
+            munmap((void*)(aligned + allocation.size), tail);
+
+        allocation.ptr = (void*)aligned;
+        allocation.backing = LargePageBacking::Default;
+
+#ifdef MADV_HUGEPAGE
+        if (size >= HUGE_PAGE_SIZE && TransparentHugePagesEnabled() &&
+            madvise(allocation.ptr, allocation.size, MADV_HUGEPAGE) == 0)
+            allocation.backing = LargePageBacking::TransparentHugePages;
+#endif
+    }
+
+    // the pages are not touched yet, so the policy decides where they are placed
+    unsigned long nodeMask[MAX_NUMA_NODES / (sizeof(unsigned long) * 8)] = {};
+    if (GetNumaNodes(nodeMask) > 1)
+        allocation.interleaved = syscall(SYS_mbind, allocation.ptr, allocation.size, MPOL_INTERLEAVE, nodeMask,
+                                         MAX_NUMA_NODES, 0) == 0;
+
+    return allocation;
+}
+
+void LargeFree(const LargeAllocation& allocation)
+{
+    if (allocation.ptr)
+        munmap(allocation.ptr, allocation.size);
+}
+
+#endif
+
+const char* LargeAllocDescription(const LargeAllocation& allocation)
+{
+    switch (allocation.backing)
+    {
+    case LargePageBacking::HugeTLB:
+        return allocation.interleaved ? "huge pages, NUMA interleaved" : "huge pages";
+    case LargePageBacking::TransparentHugePages:
+        return allocation.interleaved ? "transparent huge pages, NUMA interleaved" : "transparent huge pages";
+    default:
+        return allocation.interleaved ? "normal pages, NUMA interleaved" : "normal pages";
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef LARGEALLOC_H
+#define LARGEALLOC_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+/**
+ * @brief What backs a large allocation
+ */
+enum class LargePageBacking
+{
+    HugeTLB,              // explicit 2 MB pages reserved by the OS (MAP_HUGETLB / MEM_LARGE_PAGES)
+    TransparentHugePages, // normal mapping with the kernel asked to use huge pages (MADV_HUGEPAGE)
+    Default               // normal 4 KB pages
+};
+
+/**
+ * @brief Information about a large allocation, needed to free it
+ */
+struct LargeAllocation
+{
+    void* ptr = nullptr;
+    size_t size = 0; // size of the mapping, may be larger than the requested size
+    LargePageBacking backing = LargePageBacking::Default;
+    bool interleaved = false; // spread across all NUMA nodes
+};
+
+/**
+ * @brief Allocates zeroed memory for big arrays that are accessed randomly (TT, NNUE weights). Huge pages are tried
+ * first to cut down on TLB misses, falling back to normal pages. On machines with several NUMA nodes the pages are
+ * interleaved across the nodes, since every search thread reads from the whole array.
+ *
+ * @param size size in bytes
+ * @return LargeAllocation ptr is nullptr on failure
+ */
+LargeAllocation LargeAlloc(size_t size);
+
+/**
+ * @brief Frees memory returned by LargeAlloc
+ *
+ * @param allocation the allocation
+ */
+void LargeFree(const LargeAllocation& allocation);
+
+/**
+ * @brief Gets a short description of an allocation for logging, e.g. "transparent huge pages, NUMA interleaved"
+ *
+ * @param allocation the allocation
+ * @return const char*
+ */
+const char* LargeAllocDescription(const LargeAllocation& allocation);
+
+/**
+ * @brief Creates an object of type T in memory from LargeAlloc. The object is value initialized
+ *
+ * @param info if not nullptr, set to the allocation info
+ * @return std::shared_ptr<T> nullptr on failure
+ */
+template <typename T>
+std::shared_ptr<T> MakeSharedLarge(LargeAllocation* info = nullptr)
+{
+    LargeAllocation allocation = LargeAlloc(sizeof(T));
+    if (info)
+        *info = allocation;
+
+    if (!allocation.ptr)
+        return nullptr;
+
+    T* obj = new (allocation.ptr) T();
+    return std::shared_ptr<T>(obj, [allocation](T* p) {
+        p->~T();
+        LargeFree(allocation);
+    });
+}
+
+#endif
@@ -1,16 +1,17 @@
-
 #include "magic.h"
 #include "bitboard.h"
+#include "cpu.h"
+#include "direction.h"
 #include "random.h"
 #include "square.h"
 #include "time.h"
-#include <fstream>
+#include <array>
 #include <iostream>
-#include <cstring>
+#include <vector>
 
-Bitboard noEdgeMask[64];
+bool hasPext = false;
 
-Bitboard *slidingMoves;
+SliderBackend sliderBackend = SliderBackend::Pext;
 
 // Rook magic (800kb)
 alignas(64) Magic rookMagics[64];
@@ -18,6 +19,63 @@ alignas(64) Magic rookMagics[64];
 // Bishop magics (41kb)
 alignas(64) Magic bishopMagics[64];
 
+struct MagicNumber
+{
+    Bitboard magic;
+    unsigned int bits; // index bits, the table of the square has 2^bits entries
+};
+
+// found by the MAGIC_GEN search below, indexed by square
+// rooks 800 KB, bishops 41 KB
+constexpr MagicNumber rookMagicNumbers[64] = {
+    {0x80082010804000ULL, 12}, {0x40002000401002ULL, 11}, {0x40800c2000801000ULL, 11}, {0x200041008214200ULL, 11},
+    {0x500100500080002ULL, 11}, {0x200010802000410ULL, 11}, {0x4a80010000800200ULL, 11}, {0x100008100015222ULL, 12},
+    {0xc8800084400860ULL, 11}, {0x24401000402000ULL, 10}, {0x6041001020004101ULL, 10}, {0x81002100081000ULL, 10},
+    {0x1031001008000500ULL, 10}, {0x808808044004200ULL, 10}, {0x1110808001000200ULL, 10}, {0xc002001200410084ULL, 11},
+    {0x80084000502003ULL, 11}, {0x60404010002004ULL, 10}, {0x220808010002001ULL, 10}, {0x1010010000c20ULL, 10},
+    {0x108004004004200ULL, 10}, {0x3400808004000200ULL, 10}, {0x440088211210ULL, 10}, {0x400520008628403ULL, 11},
+    {0x200800080204000ULL, 11}, {0x4000200040100040ULL, 10}, {0x3020010100402010ULL, 10}, {0x2000080080100080ULL, 10},
+    {0xa9001100050801ULL, 10}, {0x1420040080020080ULL, 10}, {0x20d0288400100142ULL, 10}, {0x400c0200208051ULL, 11},
+    {0x8324001800080ULL, 11}, {0xc8c0004101002081ULL, 10}, {0x8400200041001106ULL, 10}, {0x2810010009002010ULL, 10},
+    {0x800080101001004ULL, 10}, {0x4008800400800201ULL, 10}, {0x800100104004208ULL, 10}, {0x20000810600004cULL, 11},
+    {0x200800040048020ULL, 11}, {0x2010004020004006ULL, 10}, {0xaa10002408002001ULL, 10}, {0x2155000e3010008ULL, 10},
+    {0x8040008008080ULL, 10}, {0x8480042010080140ULL, 10}, {0x1026020001008080ULL, 10}, {0x880908044220001ULL, 11},
+    {0x460204000801080ULL, 11}, {0x408a09202c10200ULL, 10}, {0x410010200100ULL, 10}, {0x10080010018480ULL, 10},
+    {0x800c510090100ULL, 10}, {0x106040080020080ULL, 10}, {0x1020018802100400ULL, 10}, {0xa000884c010200ULL, 11},
+    {0x8006002080401102ULL, 12}, {0x1008460100201082ULL, 11}, {0x500120009402182ULL, 11}, {0x201000050009ULL, 11},
+    {0x2008820051002ULL, 11}, {0x202000104100802ULL, 11}, {0x40008810111204ULL, 11}, {0x80164401008922ULL, 12},
+};
+constexpr MagicNumber bishopMagicNumbers[64] = {
+    {0x20585081040820ULL, 6}, {0x408c80341420000ULL, 5}, {0x10808604442560ULL, 5}, {0x1814050210010a08ULL, 5},
+    {0x2008484000001400ULL, 5}, {0x1040340200006ULL, 5}, {0x2001008210400100ULL, 5}, {0x2242004842501000ULL, 6},
+    {0x2080c08204842c80ULL, 5}, {0x404008100c088028ULL, 5}, {0x400088805082000ULL, 5}, {0x42914106a000020ULL, 5},
+    {0x108820000104ULL, 5}, {0x4206b44402402000ULL, 5}, {0x4884210042000ULL, 5}, {0x20a2010401040220ULL, 5},
+    {0x204085064082810ULL, 5}, {0x202200430041128ULL, 5}, {0x8008108002080ULL, 7}, {0x71092020408000ULL, 7},
+    {0x2200c00a00000ULL, 7}, {0x16008040500418ULL, 7}, {0x1024840208010850ULL, 5}, {0x4000202054020801ULL, 5},
+    {0x4202010f0420281ULL, 5}, {0x10040010044080ULL, 5}, {0x200241008084402ULL, 7}, {0x802008020220ULL, 9},
+    {0x208480a4002006ULL, 9}, {0x100080084a1000ULL, 7}, {0x1084024020880ULL, 5}, {0x240b0048410402c0ULL, 5},
+    {0xc142000652104ULL, 5}, {0x160a205050110cULL, 5}, {0x4002082040700ULL, 7}, {0x200208020280200ULL, 9},
+    {0x40404002a1100ULL, 9}, {0x10041021011000ULL, 7}, {0x4408022080004801ULL, 5}, {0x2404808097130400ULL, 5},
+    {0x4210842060490801ULL, 5}, {0x41009004061002ULL, 5}, {0x2004028001081ULL, 7}, {0x2200410a44001800ULL, 7},
+    {0x2012200a000104ULL, 7}, {0x82a00400208300ULL, 7}, {0x8021080210400080ULL, 5}, {0x401214401000080ULL, 5},
+    {0x403048221600402ULL, 5}, {0x116004c0a08402cULL, 5}, {0xa0084048400ULL, 5}, {0x92014020881204ULL, 5},
+    {0xc10001102020200ULL, 5}, {0x201040810144008ULL, 5}, {0x21200401404002ULL, 5}, {0x1010500081004004ULL, 5},
+    {0xd040202024282ULL, 6}, {0x400208a082010ULL, 5}, {0x100008042289002ULL, 5}, {0x80080409084820ULL, 5},
+    {0x410040490020204ULL, 5}, {0xa0423004588820ULL, 5}, {0x47514440400ULL, 5}, {0x10298208024101ULL, 6},
+};
+
+uint64_t SoftwarePext(uint64_t src, uint64_t mask)
+{
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1)
+    {
+        if (src & mask & -mask)
+            result |= bit;
+        mask &= mask - 1;
+    }
+    return result;
+}
+
 Bitboard getBlockers(Bitboard mask, unsigned int number)
 {
     Bitboard out = 0;
@@ -35,8 +93,9 @@ Bitboard getBlockers(Bitboard mask, unsigned int number)
     return out;
 }
 
-void InitNoEdgeMasks()
-{
+// everything but the edges of the board a square isn't on, blockers on the edge don't change a slider's attacks
+alignas(64) constexpr auto noEdgeMask = [] {
+    std::array<Bitboard, 64> table{};
     for (Square s = SQ_A1; s <= SQ_H8; s++)
     {
         Bitboard mask = 0;
@@ -55,301 +114,333 @@ void InitNoEdgeMasks()
         if (rank != RANK_8)
             mask |= rankBBs[RANK_8];
 
-        noEdgeMask[s] = ~mask;
+        table[s] = ~mask;
     }
+    return table;
+}();
+
+constexpr Bitboard SliderMask(Square s, bool rook)
+{
+    return (rook ? rookMasks[s] : bishopMasks[s]) & noEdgeMask[s];
 }
 
-void GenerateRookMoves(Bitboard *rookMoves, unsigned long long size)
+/**
+ * @brief Gets the attacks of a slider from the rays, each ray is cut behind its first blocker
+ */
+constexpr Bitboard SlidingAttacks(Square s, Bitboard blockers, bool rook)
 {
-    Bitboard *pointer = rookMoves;
-    memset(rookMoves, 0, size * 8.0f);
-    for (Square s = SQ_A1; s <= SQ_H8; s++)
+    constexpr Direction rookDirs[] = {NORTH, EAST, SOUTH, WEST};
+    constexpr Direction bishopDirs[] = {NORTH_EAST, NORTH_WEST, SOUTH_EAST, SOUTH_WEST};
+
+    Bitboard attacks = 0;
+    for (Direction dir : rook ? rookDirs : bishopDirs)
     {
-        Bitboard blockerMask = rookMasks[s];
+        const Bitboard ray = bitboardRays[dir][s];
+        const Bitboard blocked = ray & blockers;
+        if (!blocked)
+            attacks |= ray;
+        else
+            attacks |= ray ^ bitboardRays[dir][dir > 0 ? lsb(blocked) : msb(blocked)];
+    }
+    return attacks;
+}
 
-        blockerMask &= noEdgeMask[s];
-        unsigned int numBlockers = 1 << popCount(blockerMask);
+constexpr unsigned int IndexBits(Square s, bool rook, SliderBackend backend)
+{
+    if (backend == SliderBackend::Pext)
+        return popCount(SliderMask(s, rook));
+    return (rook ? rookMagicNumbers : bishopMagicNumbers)[s].bits;
+}
 
-        Magic &magic = rookMagics[s];
+constexpr size_t SliderTableSize(bool rook, SliderBackend backend)
+{
+    size_t size = 0;
+    for (Square s = SQ_A1; s <= SQ_H8; s++)
+        size += 1ULL << IndexBits(s, rook, backend);
+    return size;
+}
 
-        magic.moves = pointer;
-        magic.mask = blockerMask;
+/**
+ * @brief Builds the attack tables of every square of one piece type for a backend, laid out one after the other. The
+ * blockers are enumerated with the carry-rippler trick, which visits them in the order of their PEXT index
+ */
+template <bool rook, SliderBackend backend>
+constexpr auto MakeSliderTable()
+{
+    std::array<Bitboard, SliderTableSize(rook, backend)> table{};
 
-        pointer += numBlockers;
+    size_t offset = 0;
+    for (Square s = SQ_A1; s <= SQ_H8; s++)
+    {
+        const Bitboard mask = SliderMask(s, rook);
+        const MagicNumber number = (rook ? rookMagicNumbers : bishopMagicNumbers)[s];
 
-        for (unsigned int i = 0; i < numBlockers; i++)
+        // with fewer index bits than mask bits several blockers share an entry, they all have the same attacks
+        Bitboard blockers = 0;
+        size_t index = 0;
+        do
         {
-            Bitboard blocker = getBlockers(blockerMask, i);
+            if (backend == SliderBackend::Multiply)
+                index = (blockers * number.magic) >> (64 - number.bits);
 
-            int index = _pext_u64(blocker, blockerMask);
+            table[offset + index++] = SlidingAttacks(s, blockers, rook);
+            blockers = (blockers - mask) & mask;
+        } while (blockers);
 
-            magic.moves[index] = sendRay(s, NORTH, blocker) | sendRay(s, SOUTH, blocker) | sendRay(s, EAST, blocker) |
-                                 sendRay(s, WEST, blocker);
-        }
+        offset += 1ULL << IndexBits(s, rook, backend);
     }
+
+    return table;
 }
 
-void GenerateBishopMoves(Bitboard *bishopMoves, unsigned long long size)
+// The attack tables are generated at compile time and live in read-only data, only the backends this build can use
+#ifndef USE_MULTIPLY_SLIDERS
+alignas(64) constexpr auto rookPextMoves = MakeSliderTable<true, SliderBackend::Pext>();
+alignas(64) constexpr auto bishopPextMoves = MakeSliderTable<false, SliderBackend::Pext>();
+#endif
+
+#ifndef USE_PEXT_SLIDERS
+alignas(64) constexpr auto rookMultiplyMoves = MakeSliderTable<true, SliderBackend::Multiply>();
+alignas(64) constexpr auto bishopMultiplyMoves = MakeSliderTable<false, SliderBackend::Multiply>();
+#endif
+
+/**
+ * @brief Points the magics of one piece type at their attack tables
+ */
+void SetupMagics(Magic *magics, const MagicNumber *numbers, bool rook, const Bitboard *pointer, SliderBackend backend)
 {
-    Bitboard *pointer = bishopMoves;
-    memset(bishopMoves, 0, size * 8.0f);
-
     for (Square s = SQ_A1; s <= SQ_H8; s++)
     {
-        Bitboard blockerMask = bishopMasks[s];
-
-        blockerMask &= noEdgeMask[s];
-        unsigned int numBlockers = 1 << popCount(blockerMask);
-
-        Magic &magic = bishopMagics[s];
+        Magic &magic = magics[s];
 
+        magic.mask = SliderMask(s, rook);
+        magic.magic = numbers[s].magic;
+        magic.shift = 64 - numbers[s].bits;
         magic.moves = pointer;
-        magic.mask = blockerMask;
-
-        pointer += numBlockers;
-
-        for (unsigned int i = 0; i < numBlockers; i++)
-        {
-            Bitboard blocker = getBlockers(blockerMask, i);
 
-            int index = _pext_u64(blocker, blockerMask);
-
-            magic.moves[index] = sendRay(s, NORTH_EAST, blocker) | sendRay(s, SOUTH_WEST, blocker) |
-                                 sendRay(s, SOUTH_EAST, blocker) | sendRay(s, NORTH_WEST, blocker);
-        }
+        pointer += 1ULL << IndexBits(s, rook, backend);
     }
 }
 
-void InitMagics()
+/**
+ * @brief Points the magics of both piece types at the tables of a backend
+ */
+void InitSliders(Magic *rooks, Magic *bishops, SliderBackend backend)
 {
-    InitNoEdgeMasks();
-
-    unsigned long long bishopSize = 0;
-
-    for (Square s = SQ_A1; s <= SQ_H8; s++)
+#ifndef USE_MULTIPLY_SLIDERS
+    if (backend == SliderBackend::Pext)
     {
-        Bitboard blockerMask = bishopMasks[s];
-
-        blockerMask &= noEdgeMask[s];
-        unsigned int numBlockers = 1 << popCount(blockerMask);
-
-        bishopSize += numBlockers;
+        SetupMagics(rooks, rookMagicNumbers, true, rookPextMoves.data(), backend);
+        SetupMagics(bishops, bishopMagicNumbers, false, bishopPextMoves.data(), backend);
     }
+#endif
 
-    // std::cout << "Bishop magic size: " << (unsigned long long)((float)bishopSize / 1024.0f * 8.0f) << "kb" << std::endl;
-
-    unsigned long long rookSize = 0;
-
-    for (Square s = SQ_A1; s <= SQ_H8; s++)
+#ifndef USE_PEXT_SLIDERS
+    if (backend == SliderBackend::Multiply)
     {
-        Bitboard blockerMask = rookMasks[s];
-
-        blockerMask &= noEdgeMask[s];
-        unsigned int numBlockers = 1 << popCount(blockerMask);
-
-        rookSize += numBlockers;
+        SetupMagics(rooks, rookMagicNumbers, true, rookMultiplyMoves.data(), backend);
+        SetupMagics(bishops, bishopMagicNumbers, false, bishopMultiplyMoves.data(), backend);
     }
-
-    // std::cout << "Rook magic size: " << (unsigned long long)((float)rookSize / 1024.0f * 8.0f) << "kb" << std::endl;
-
-    slidingMoves = new (std::align_val_t(64)) Bitboard[rookSize + bishopSize];
-
-    GenerateBishopMoves(slidingMoves + rookSize, bishopSize);
-    GenerateRookMoves(slidingMoves, rookSize);
+#endif
 }
 
-#ifdef MAGIC_GEN
+void InitMagics()
+{
+    hasPext = GetCpuFeatures().bmi2;
+
+#if defined(USE_PEXT_SLIDERS)
+    sliderBackend = SliderBackend::Pext;
+#elif defined(USE_MULTIPLY_SLIDERS)
+    sliderBackend = SliderBackend::Multiply;
+#else
+    // PEXT is microcoded on AMD before Zen 3, a multiply and a shift are much faster there
+    sliderBackend = hasPext && !GetCpuFeatures().slowPext ? SliderBackend::Pext : SliderBackend::Multiply;
+#endif
+
+    InitSliders(rookMagics, bishopMagics, sliderBackend);
+}
 
-unsigned long long getMagicSize(Magic *magics)
+const char* SliderBackendName(SliderBackend backend)
 {
-    unsigned long long size = 0;
-    for (int i = 0; i < 64; i++)
-    {
-        size += (1 << magics[i].offset) * 8;
-    }
-    return size;
+    if (backend == SliderBackend::Multiply)
+        return "magic multiply";
+    return hasPext ? "hardware PEXT" : "software PEXT";
 }
 
-void GenerateRookBlockers()
+/**
+ * @brief Times the lookups of one backend on its own magics, with the backend fixed at compile time like GetRookMoves
+ */
+template <SliderBackend backend>
+static Bitboard TimeSliderLookups(const Magic *rooks, const Magic *bishops, const std::vector<Square> &squares,
+                                  const std::vector<Bitboard> &occupancies, int numRounds,
+                                  unsigned long long &nanoseconds)
 {
-    for (Square s = SQ_A1; s <= SQ_H8; s++)
+    Bitboard sum = 0;
+    unsigned long long start = getTimeNS();
+    for (int r = 0; r < numRounds; r++)
     {
-        Bitboard blockerMask = rookMasks[s];
-
-        blockerMask &= noEdgeMask[s];
-        unsigned int numBlockers = 1 << popCount(blockerMask);
-
-        for (unsigned long long i = 0; i < numBlockers; i++)
+        for (size_t i = 0; i < squares.size(); i++)
         {
-            Bitboard blockers = getBlockers(blockerMask, i);
-            _rookBlockers[s][i] = blockers;
+            const Magic &rook = rooks[squares[i]];
+            const Magic &bishop = bishops[squares[i]];
+            sum ^= rook.moves[rook.Index(occupancies[i], backend)] ^
+                   bishop.moves[bishop.Index(occupancies[i] ^ sum, backend)];
         }
     }
+    nanoseconds = getTimeNS() - start;
+
+    return sum;
 }
 
-void GenerateBishopBlockers()
+void BenchmarkSliders()
 {
-    for (Square s = SQ_A1; s <= SQ_H8; s++)
+    constexpr int numQueries = 4096;
+    constexpr int numRounds = 2000;
+
+    // random squares and occupancies with about a third of the board filled, like a middlegame
+    std::vector<Square> squares(numQueries);
+    std::vector<Bitboard> occupancies(numQueries);
+    for (int i = 0; i < numQueries; i++)
     {
-        Bitboard blockerMask = bishopMasks[s];
+        squares[i] = Square(RandNum() & 63);
+        occupancies[i] = RandNum() & (RandNum() | RandNum());
+    }
 
-        blockerMask &= noEdgeMask[s];
-        unsigned int numBlockers = 1 << popCount(blockerMask);
+#if defined(USE_PEXT_SLIDERS)
+    const SliderBackend backends[] = {SliderBackend::Pext};
+#elif defined(USE_MULTIPLY_SLIDERS)
+    const SliderBackend backends[] = {SliderBackend::Multiply};
+#else
+    const SliderBackend backends[] = {SliderBackend::Pext, SliderBackend::Multiply};
+#endif
 
-        for (unsigned int i = 0; i < numBlockers; i++)
-        {
-            Bitboard blocker = getBlockers(blockerMask, i);
-            _bishopBlockers[s][i] = blocker;
-        }
+    // every backend gets its own magics, the global ones may be in use by a search
+    for (SliderBackend backend : backends)
+    {
+        Magic rooks[64], bishops[64];
+        InitSliders(rooks, bishops, backend);
+
+        unsigned long long nanoseconds;
+        const Bitboard sum =
+            backend == SliderBackend::Pext
+                ? TimeSliderLookups<SliderBackend::Pext>(rooks, bishops, squares, occupancies, numRounds, nanoseconds)
+                : TimeSliderLookups<SliderBackend::Multiply>(rooks, bishops, squares, occupancies, numRounds,
+                                                             nanoseconds);
+
+        const unsigned long long lookups = 2ULL * numQueries * numRounds;
+        std::cout << SliderBackendName(backend) << (backend == sliderBackend ? " (selected)" : "") << ": "
+                  << lookups * 1000 / std::max(nanoseconds, 1ULL) << " M attacks/s (checksum " << (sum & 0xffff)
+                  << ")" << std::endl;
     }
 }
 
-bool TestMagic(Key magicNum, Bitboard *list, unsigned int size, unsigned short numBits)
-{
-    bool *test = new bool[1 << numBits];
-
-    memset(test, 0, 1 << numBits);
+#ifdef MAGIC_GEN
 
-    bool success = true;
+/*
+    Searches the multiply magics in rookMagicNumbers and bishopMagicNumbers. It is built on its own:
+        g++ -std=c++17 -O2 -DMAGIC_GEN -fconstexpr-ops-limit=4294967296 -iquote src \
+            src/magic.cpp src/bitboard.cpp src/square.cpp src/random.cpp src/cpu.cpp -o magicgen
+    "magicgen [seconds]" first finds a magic with as many index bits as the mask has squares for every square, then
+    spends up to the given number of seconds per square (default 1) looking for magics with fewer bits, which exist
+    because different blockers can share an index if they give the same attacks. The tables are printed to stdout.
+*/
+
+// attempt number of the last write to each index, so the table doesn't have to be cleared between attempts
+struct MagicSearch
+{
+    std::vector<Bitboard> blockers;
+    std::vector<Bitboard> attacks;
+    std::vector<Bitboard> table;
+    std::vector<unsigned int> written;
+    unsigned int attempt = 0;
+};
+
+bool TestMagic(MagicSearch& search, Bitboard mask, Bitboard magicNum, unsigned int bits)
+{
+    // magics that don't spread the mask over the top byte rarely work
+    if (popCount((mask * magicNum) >> 56) < 6)
+        return false;
 
-    for (unsigned int i = 0; i < size; i++)
+    search.attempt++;
+    for (size_t i = 0; i < search.blockers.size(); i++)
     {
-        Bitboard blockers = list[i];
-        int index = (blockers * magicNum) >> (64 - numBits);
-        if (test[index])
+        const unsigned int index = (search.blockers[i] * magicNum) >> (64 - bits);
+        if (search.written[index] != search.attempt)
         {
-            success = false;
-            break;
+            search.written[index] = search.attempt;
+            search.table[index] = search.attacks[i];
         }
-        test[index] = true;
+        else if (search.table[index] != search.attacks[i])
+            return false;
     }
 
-    delete[] test;
-    return success;
+    return true;
 }
 
-void moveCursorUpOneLine()
+MagicNumber FindMagic(Square s, bool rook, unsigned long long milliseconds)
 {
-    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-
-    if (GetConsoleScreenBufferInfo(hConsole, &csbi))
-    {
-        COORD pos = csbi.dwCursorPosition;
-        if (pos.Y > 0)
-            pos.Y -= 1;
-        pos.X = 0;
-        SetConsoleCursorPosition(hConsole, pos);
-    }
-}
+    const Bitboard mask = (rook ? rookMasks[s] : bishopMasks[s]) & noEdgeMask[s];
+    const unsigned int maskBits = popCount(mask);
 
-void GenerateMagics()
-{
-    for (int i = 0; i < 64; i++)
+    MagicSearch search;
+    for (unsigned int i = 0; i < (1u << maskBits); i++)
     {
-
-        rookMagics[i].magic = 0ULL;
-        rookMagics[i].offset = popCount(rookMasks[i] & noEdgeMask[i]) + 4;
-
-        bishopMagics[i].magic = 0ULL;
-        bishopMagics[i].offset = popCount(bishopMasks[i] & noEdgeMask[i]) + 4;
+        const Bitboard blockers = getBlockers(mask, i);
+        search.blockers.push_back(blockers);
+        search.attacks.push_back(SlidingAttacks(s, blockers, rook));
     }
+    search.table.resize(1 << maskBits);
+    search.written.resize(1 << maskBits);
 
-    while (true)
+    MagicNumber best = {0, maskBits + 1};
+    const unsigned long long end = getTime() + milliseconds;
+    while (!best.magic || getTime() < end)
     {
-        for (Square s = SQ_A1; s <= SQ_H8; s++)
+        const unsigned int bits = best.bits - 1;
+        for (int tries = 0; tries < 100000; tries++)
         {
-            unsigned long long magicNum = RandNum() & RandNum() & RandNum();
-
-            unsigned int rookSize = 1 << popCount(rookMasks[s] & noEdgeMask[s]);
-            unsigned int bishopSize = 1 << popCount(bishopMasks[s] & noEdgeMask[s]);
-
-            unsigned char rookOffset = rookMagics[s].offset - 1;
-            unsigned char bishopOffset = bishopMagics[s].offset - 1;
-
-            while (TestMagic(magicNum, _rookBlockers[s], rookSize, rookOffset))
+            const Bitboard magicNum = RandNum() & RandNum() & RandNum();
+            if (TestMagic(search, mask, magicNum, bits))
             {
-                rookMagics[s].magic = magicNum;
-                rookMagics[s].offset = rookOffset;
-                rookOffset--;
-
-                moveCursorUpOneLine();
-                std::cout << "Rook Size: " << (unsigned int)(getMagicSize(rookMagics) / 1024) << " kb            "
-                          << "\nBishop Size: " << (unsigned int)(getMagicSize(bishopMagics) / 1024) << " kb           ";
-            }
-
-            magicNum = RandNum() & RandNum() & RandNum();
-
-            while (TestMagic(magicNum, _bishopBlockers[s], bishopSize, bishopOffset))
-            {
-                bishopMagics[s].magic = magicNum;
-                bishopMagics[s].offset = bishopOffset;
-                bishopOffset--;
-                std::cout << "\rBishop Size: " << (unsigned int)(getMagicSize(bishopMagics) / 1024) << " kb           ";
+                best = {magicNum, bits};
+                break;
             }
         }
     }
-}
 
-void OutputMagics()
-{
-    std::fstream magicOut("magicOut.txt", std::ios::out);
-    magicOut << "Magic rookMagics[] = {\n";
-    for (int i = 0; i < 64; i++)
-    {
-        magicOut << "Magic(" << rookMagics[i].magic << "ULL, " << (unsigned int)rookMagics[i].offset << "),\n";
-    }
-    magicOut << "};\n";
-    magicOut << "Magic bishopMagics[] = {\n";
-    for (int i = 0; i < 64; i++)
-    {
-        magicOut << "Magic(" << bishopMagics[i].magic << "ULL, " << (unsigned int)bishopMagics[i].offset << "),\n";
-    }
-    magicOut << "};" << std::endl;
-
-    magicOut.close();
+    return best;
 }
 
-BOOL WINAPI ExitCatcher(DWORD event)
+void PrintMagics(const char* name, const MagicNumber* magics)
 {
-    switch (event)
+    std::cout << "constexpr MagicNumber " << name << "[64] = {\n";
+    for (Square s = SQ_A1; s <= SQ_H8; s++)
     {
-    case CTRL_C_EVENT:
-        std::cout << "\nexiting..." << std::endl;
-        OutputMagics();
-        exit(0);
-    case CTRL_BREAK_EVENT:
-        std::cout << "\nexiting..." << std::endl;
-        OutputMagics();
-        exit(0);
-    default:
-        return FALSE;
+        std::cout << (s % 4 == 0 ? "    " : " ") << "{0x" << std::hex << magics[s].magic << std::dec << "ULL, "
+                  << magics[s].bits << "}," << (s % 4 == 3 ? "\n" : "");
     }
+    std::cout << "};" << std::endl;
 }
 
-int main()
+int main(int argc, char** argv)
 {
-    if (SetConsoleCtrlHandler(ExitCatcher, TRUE))
-    {
-        std::cout << "successfully set exit handler!" << std::endl;
-    }
-    else
+    const unsigned long long milliseconds = (argc > 1 ? std::atof(argv[1]) : 1.0) * 1000;
+
+    MagicNumber rook[64], bishop[64];
+    unsigned long long rookSize = 0, bishopSize = 0;
+    for (Square s = SQ_A1; s <= SQ_H8; s++)
     {
-        std::cout << "failed to set exit handler" << std::endl;
-        return 1;
+        rook[s] = FindMagic(s, true, milliseconds);
+        bishop[s] = FindMagic(s, false, milliseconds);
+        rookSize += 1ULL << rook[s].bits;
+        bishopSize += 1ULL << bishop[s].bits;
+        std::cerr << "square " << sqrToString(s) << ": rook " << rook[s].bits << " bits, bishop " << bishop[s].bits << " bits"
+                  << std::endl;
     }
 
-    initSquare();
-    initBBs();
-    InitNoEdgeMasks();
-
-    BENCHMARK();
-    GenerateRookBlockers();
-    GenerateBishopBlockers();
-
-    GenerateMagics();
-
-    GenerateRookMoves();
-    GenerateBishopMoves();
+    std::cout << "// rooks " << rookSize * sizeof(Bitboard) / 1024 << " KB, bishops "
+              << bishopSize * sizeof(Bitboard) / 1024 << " KB\n";
+    PrintMagics("rookMagicNumbers", rook);
+    PrintMagics("bishopMagicNumbers", bishop);
 }
 #endif
\ No newline at end of file
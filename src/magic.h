@@ -5,22 +5,82 @@
 #include "types.h"
 #include <immintrin.h>
 
+// true if the CPU has the BMI2 PEXT instruction, set by InitMagics
+extern bool hasPext;
+
+/**
+ * @brief Portable PEXT for CPUs without BMI2, gives the same result as the instruction
+ */
+uint64_t SoftwarePext(uint64_t src, uint64_t mask);
+
+/**
+ * @brief Gathers the bits of src selected by mask into the low bits of the result. Builds that target BMI2 use the
+ * instruction directly, portable builds check hasPext (always predicted correctly) and fall back to SoftwarePext
+ */
+inline uint64_t Pext(uint64_t src, uint64_t mask)
+{
+#ifdef __BMI2__
+    return _pext_u64(src, mask);
+#else
+    if (hasPext)
+    {
+        // inline asm instead of the intrinsic, which needs BMI2 enabled for the whole translation unit
+        uint64_t result;
+        __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(src), "r"(mask));
+        return result;
+    }
+    return SoftwarePext(src, mask);
+#endif
+}
+
+/**
+ * @brief How a slider's blockers are turned into an index into its attack table
+ */
+enum class SliderBackend
+{
+    Pext,    // the blockers under the mask gathered with PEXT, the table has 2^popcount(mask) entries
+    Multiply // the masked blockers multiplied by a magic number, the index is the top bits of the product
+};
+
+#if defined(USE_PEXT_SLIDERS) && defined(USE_MULTIPLY_SLIDERS)
+#error "USE_PEXT_SLIDERS and USE_MULTIPLY_SLIDERS are mutually exclusive"
+#endif
+
+// the backend of the attack tables, set by InitMagics: fixed by USE_PEXT_SLIDERS / USE_MULTIPLY_SLIDERS, otherwise
+// PEXT when the CPU has a fast one
+extern SliderBackend sliderBackend;
+
 struct Magic
 {
-    Bitboard* moves;
+    const Bitboard* moves;
     Bitboard mask;
+    Bitboard magic;     // multiply backend only
+    unsigned int shift; // multiply backend only, 64 - index bits
+
+    Magic() : moves(nullptr), mask(0), magic(0), shift(0)
+    {
+    }
 
-    Magic() : moves(nullptr), mask(0)
+    Magic(Bitboard mask) : moves(nullptr), mask(mask), magic(0), shift(0)
     {
     }
 
-    Magic(Bitboard mask) : moves(nullptr), mask(mask)
+    inline unsigned int Index(const Bitboard blockers, const SliderBackend backend) const
     {
+        if (backend == SliderBackend::Pext)
+            return Pext(blockers, mask);
+        return ((blockers & mask) * magic) >> shift;
     }
 
-    inline Bitboard GetMoves(const Bitboard blockers)
+    inline Bitboard GetMoves(const Bitboard blockers) const
     {
-        return moves[_pext_u64(blockers, mask)];
+#if defined(USE_PEXT_SLIDERS)
+        return moves[Index(blockers, SliderBackend::Pext)];
+#elif defined(USE_MULTIPLY_SLIDERS)
+        return moves[Index(blockers, SliderBackend::Multiply)];
+#else
+        return moves[Index(blockers, sliderBackend)];
+#endif
     }
 };
 
@@ -29,6 +89,19 @@ extern Magic bishopMagics[64];
 
 void InitMagics();
 
+/**
+ * @brief Gets the name of a slider backend for logging
+ *
+ * @return const char*
+ */
+const char* SliderBackendName(SliderBackend backend);
+
+/**
+ * @brief Measures the slider attack lookups per second of every backend this build can use and prints the results.
+ * Each backend is timed on magics of its own, the global ones are left alone, so it is safe during a search
+ */
+void BenchmarkSliders();
+
 inline Bitboard GetRookMoves(const Bitboard blockers, const Square sqr)
 {
     return rookMagics[sqr].GetMoves(blockers);
@@ -0,0 +1,95 @@
+#include "mappedFile.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32) || defined(_WIN64)
+
+MappedFile MapFile(const std::string& filename)
+{
+    MappedFile file;
+
+    HANDLE fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(fileHandle);
+        return file;
+    }
+
+    // the mapping object keeps the file open, the file handle itself is no longer needed
+    HANDLE mapping = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(fileHandle);
+    if (!mapping)
+        return file;
+
+    const void* ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!ptr)
+    {
+        CloseHandle(mapping);
+        return file;
+    }
+
+    file.ptr = ptr;
+    file.size = (size_t)size.QuadPart;
+    file.handle = mapping;
+    return file;
+}
+
+void UnmapFile(const MappedFile& file)
+{
+    if (file.ptr)
+    {
+        UnmapViewOfFile(file.ptr);
+        CloseHandle(file.handle);
+    }
+}
+
+#elif defined(__linux__)
+
+MappedFile MapFile(const std::string& filename)
+{
+    MappedFile file;
+
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+        return file;
+
+    struct stat info;
+    if (fstat(fd, &info) == -1 || info.st_size == 0)
+    {
+        close(fd);
+        return file;
+    }
+
+    // the mapping keeps its own reference to the file
+    void* ptr = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+        return file;
+
+    // the whole file is about to be read, start reading it in now
+    madvise(ptr, info.st_size, MADV_WILLNEED);
+
+    file.ptr = ptr;
+    file.size = (size_t)info.st_size;
+    return file;
+}
+
+void UnmapFile(const MappedFile& file)
+{
+    if (file.ptr)
+        munmap(const_cast<void*>(file.ptr), file.size);
+}
+
+#endif
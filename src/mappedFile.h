@@ -0,0 +1,33 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief A file mapped read-only into memory. The pages come straight from the OS page cache, so every process mapping
+ * the same file shares a single copy of it
+ */
+struct MappedFile
+{
+    const void* ptr = nullptr; // page aligned
+    size_t size = 0;
+    void* handle = nullptr; // file mapping object on Windows, unused elsewhere
+};
+
+/**
+ * @brief Maps a whole file read-only
+ *
+ * @param filename the file
+ * @return MappedFile ptr is nullptr on failure (including empty files)
+ */
+MappedFile MapFile(const std::string& filename);
+
+/**
+ * @brief Unmaps a file mapped by MapFile
+ *
+ * @param file the mapping
+ */
+void UnmapFile(const MappedFile& file);
+
+#endif
@@ -136,18 +136,21 @@ void generatePawnMoves(const Board& board, MoveList* list, MovegenMasks* masks)
     Bitboard promotingPawnsForward = singlePushes & promotingPawnsMask;
     singlePushes ^= promotingPawnsForward;
 
-    while (promotingPawnsForward)
+    if constexpr (mType != QUIET) // promotions are generated with the captures
     {
-        const Square to = popLSB(promotingPawnsForward);
-        const Square from = to - forward;
+        while (promotingPawnsForward)
+        {
+            const Square to = popLSB(promotingPawnsForward);
+            const Square from = to - forward;
 
-        list->addMove(Move(from, to, PROMOTION, QUEEN));
-        list->addMove(Move(from, to, PROMOTION, ROOK));
-        list->addMove(Move(from, to, PROMOTION, BISHOP));
-        list->addMove(Move(from, to, PROMOTION, KNIGHT));
+            list->addMove(Move(from, to, PROMOTION, QUEEN));
+            list->addMove(Move(from, to, PROMOTION, ROOK));
+            list->addMove(Move(from, to, PROMOTION, BISHOP));
+            list->addMove(Move(from, to, PROMOTION, KNIGHT));
+        }
     }
 
-    if constexpr (mType == ALL_MOVES)
+    if constexpr (mType != CAPTURE)
     {
         Bitboard doublePushes = shift(singlePushesUnchecked, forward) & empty &
                                 (whiteToMove ? rankBBs[RANK_4] : rankBBs[RANK_5]) & masks->checkBB;
@@ -178,6 +181,9 @@ void generatePawnMoves(const Board& board, MoveList* list, MovegenMasks* masks)
 #endif
     }
 
+    if constexpr (mType == QUIET)
+        return;
+
     const Bitboard attacksWestPinned =
         shift(pinnedPawnsD & ~fileBBs[FILE_A] & ~masks->pinnedS, forwardWest) & masks->pinnedD;
     const Bitboard attacksWestUnpinned = shift(unpinnedPawnsD & ~fileBBs[FILE_A] & ~masks->pinnedS, forwardWest);
@@ -276,8 +282,9 @@ void generateKnightMoves(const Board& board, MoveList* list, MovegenMasks* masks
         const Bitboard moves = knightMoves[from] & masks->checkBB;
         Bitboard captures = moves & board.getBB(~color);
 
-        BitboardToMoves<CAPTURE>(from, captures, list);
-        if constexpr (mType == ALL_MOVES)
+        if constexpr (mType != QUIET)
+            BitboardToMoves<CAPTURE>(from, captures, list);
+        if constexpr (mType != CAPTURE)
         {
             Bitboard quiets = moves & ~board.getBB(ALL_PIECES);
             BitboardToMoves<QUIET>(from, quiets, list);
@@ -303,9 +310,10 @@ void generateBishopMoves(const Board& board, MoveList* list, MovegenMasks* masks
         const Bitboard moves = GetBishopMoves(blockers, from) & masks->pinnedD & masks->checkBB;
 
         const Bitboard captures = moves & enemy;
-        BitboardToMoves<CAPTURE>(from, captures, list);
+        if constexpr (mType != QUIET)
+            BitboardToMoves<CAPTURE>(from, captures, list);
 
-        if constexpr (mType == ALL_MOVES)
+        if constexpr (mType != CAPTURE)
         {
             const Bitboard quiets = moves & board.getBB(EMPTY);
             BitboardToMoves<QUIET>(from, quiets, list);
@@ -318,9 +326,10 @@ void generateBishopMoves(const Board& board, MoveList* list, MovegenMasks* masks
         const Bitboard moves = GetBishopMoves(blockers, from) & masks->checkBB;
 
         const Bitboard captures = moves & enemy;
-        BitboardToMoves<CAPTURE>(from, captures, list);
+        if constexpr (mType != QUIET)
+            BitboardToMoves<CAPTURE>(from, captures, list);
 
-        if constexpr (mType == ALL_MOVES)
+        if constexpr (mType != CAPTURE)
         {
             const Bitboard quiets = moves & board.getBB(EMPTY);
             BitboardToMoves<QUIET>(from, quiets, list);
@@ -345,9 +354,10 @@ void generateRookMoves(const Board& board, MoveList* list, MovegenMasks* masks)
         const Bitboard moves = GetRookMoves(blockers, from) & masks->pinnedS & masks->checkBB;
 
         const Bitboard captures = moves & enemy;
-        BitboardToMoves<CAPTURE>(from, captures, list);
+        if constexpr (mType != QUIET)
+            BitboardToMoves<CAPTURE>(from, captures, list);
 
-        if constexpr (mType == ALL_MOVES)
+        if constexpr (mType != CAPTURE)
         {
             const Bitboard quiets = moves & board.getBB(EMPTY);
             BitboardToMoves<QUIET>(from, quiets, list);
@@ -360,9 +370,10 @@ void generateRookMoves(const Board& board, MoveList* list, MovegenMasks* masks)
         const Bitboard moves = GetRookMoves(blockers, from) & masks->checkBB;
 
         const Bitboard captures = moves & enemy;
-        BitboardToMoves<CAPTURE>(from, captures, list);
+        if constexpr (mType != QUIET)
+            BitboardToMoves<CAPTURE>(from, captures, list);
 
-        if constexpr (mType == ALL_MOVES)
+        if constexpr (mType != CAPTURE)
         {
             const Bitboard quiets = moves & board.getBB(EMPTY);
             BitboardToMoves<QUIET>(from, quiets, list);
@@ -401,9 +412,10 @@ void generateQueenMoves(const Board& board, MoveList* list, MovegenMasks* masks)
         moves &= masks->checkBB;
 
         const Bitboard captures = moves & enemy;
-        BitboardToMoves<CAPTURE>(from, captures, list);
+        if constexpr (mType != QUIET)
+            BitboardToMoves<CAPTURE>(from, captures, list);
 
-        if constexpr (mType == ALL_MOVES)
+        if constexpr (mType != CAPTURE)
         {
             const Bitboard quiets = moves & empty;
             BitboardToMoves<QUIET>(from, quiets, list);
@@ -416,19 +428,52 @@ void generateKingMoves(const Board& board, MoveList* list)
 {
     PROFILE_FUNC();
     const Square from = lsb(board.getBB(color, KING));
-    const Bitboard open = ~board.getAttacked(~color);
+
+    // the king can't hide behind itself, so the squares are checked without it on the board
+    const Bitboard occupied = board.getBB(ALL_PIECES) ^ sqrToBB(from);
+
+    // only the few squares the king can reach are checked instead of generating all of the enemy's attacks
+    Bitboard targets = kingMoves[from] & ~board.getBB(color);
+    if constexpr (mType == CAPTURE)
+        targets &= board.getBB(~color);
+    else if constexpr (mType == QUIET)
+        targets &= board.getBB(EMPTY);
+
+    Bitboard moves = 0;
+    while (targets)
+    {
+        const Square to = popLSB(targets);
+        if (!board.isAttacked(to, ~color, occupied))
+            setBit(moves, to);
+    }
 
     const Bitboard enemy = board.getBB(~color);
-    const Bitboard moves = kingMoves[from] & open;
 
-    if constexpr (mType == ALL_MOVES)
+    if constexpr (mType != CAPTURE)
     {
         Bitboard quiets = moves & board.getBB(EMPTY);
         BitboardToMoves<QUIET>(from, quiets, list);
     }
 
-    Bitboard captures = moves & enemy;
-    BitboardToMoves<CAPTURE>(from, captures, list);
+    if constexpr (mType != QUIET)
+    {
+        Bitboard captures = moves & enemy;
+        BitboardToMoves<CAPTURE>(from, captures, list);
+    }
+}
+
+/**
+ * @brief Checks if none of the squares are attacked by a side
+ */
+template <Color color>
+inline bool isSafe(const Board& board, Bitboard squares)
+{
+    while (squares)
+    {
+        if (board.isAttacked(popLSB(squares), color))
+            return false;
+    }
+    return true;
 }
 
 template <Color color>
@@ -438,21 +483,19 @@ void generateCastlingMoves(const Board& board, MoveList* list)
     const Bitboard blockers = board.getBB(ALL_PIECES);
     const CastlingRights castleRights = board.getState()->castling;
 
-    const Bitboard open = ~(blockers | board.getAttacked(~color));
-
     if constexpr (color == WHITE)
     {
         // Short castle
-        if ((castleRights & CASTLE_WK) &&                          // has castle right
-            (open & castleBBs[CASTLE_WK]) == castleBBs[CASTLE_WK]) // no obstructions between king and rook
+        if ((castleRights & CASTLE_WK) &&                // has castle right
+            !(blockers & castleBBs[CASTLE_WK]) &&        // no obstructions between king and rook
+            isSafe<BLACK>(board, castleBBs[CASTLE_WK])) // no attacked squares where king moves through
         {
             list->addMove(Move(SQ_E1, SQ_G1, CASTLE, EMPTY));
         }
         // Long castle
-        if ((castleRights & CASTLE_WQ) && // has castle right
-            ((open & castleBBs[CASTLE_WQ]) ==
-             castleBBs[CASTLE_WQ]) &&            // no attacked squares or pieces where king moves through
-            (blockers & sqrToBB(SQ_B1)) == 0ULL) // no piecce next to rook
+        if ((castleRights & CASTLE_WQ) &&                            // has castle right
+            !(blockers & (castleBBs[CASTLE_WQ] | sqrToBB(SQ_B1))) && // no piecce between king and rook
+            isSafe<BLACK>(board, castleBBs[CASTLE_WQ]))             // no attacked squares where king moves through
         {
             list->addMove(Move(SQ_E1, SQ_C1, CASTLE, EMPTY));
         }
@@ -460,13 +503,14 @@ void generateCastlingMoves(const Board& board, MoveList* list)
     else
     {
         // Short castle
-        if ((castleRights & CASTLE_BK) && ((open & castleBBs[CASTLE_BK]) == castleBBs[CASTLE_BK]))
+        if ((castleRights & CASTLE_BK) && !(blockers & castleBBs[CASTLE_BK]) &&
+            isSafe<WHITE>(board, castleBBs[CASTLE_BK]))
         {
             list->addMove(Move(SQ_E8, SQ_G8, CASTLE, EMPTY));
         }
         // Long castle
-        if ((castleRights & CASTLE_BQ) && ((open & castleBBs[CASTLE_BQ]) == castleBBs[CASTLE_BQ]) &&
-            (blockers & sqrToBB(SQ_B8)) == 0ULL)
+        if ((castleRights & CASTLE_BQ) && !(blockers & (castleBBs[CASTLE_BQ] | sqrToBB(SQ_B8))) &&
+            isSafe<WHITE>(board, castleBBs[CASTLE_BQ]))
         {
             list->addMove(Move(SQ_E8, SQ_C8, CASTLE, EMPTY));
         }
@@ -495,10 +539,8 @@ void generateMoves(Board& board, MoveList* list)
                 checkBB = bitboardPaths[king][lsb(checkers)];
         }
 
-        Bitboard pinnedS;
-        Bitboard pinnedD;
-        board.computePins(pinnedS, pinnedD);
-        MovegenMasks masks = {checkBB, pinnedS, pinnedD};
+        const BoardState* checkInfo = board.getCheckInfo();
+        MovegenMasks masks = {checkBB, checkInfo->pinnedS, checkInfo->pinnedD};
 
         generatePawnMoves<type, color>(board, list, &masks);
         generateKnightMoves<type, color>(board, list, &masks);
@@ -506,7 +548,7 @@ void generateMoves(Board& board, MoveList* list)
         generateRookMoves<type, color>(board, list, &masks);
         generateQueenMoves<type, color>(board, list, &masks);
 
-        if constexpr (type == ALL_MOVES)
+        if constexpr (type != CAPTURE)
         {
             if (checkers == 0ULL)
                 generateCastlingMoves<color>(board, list);
@@ -519,4 +561,7 @@ template void generateMoves<ALL_MOVES, WHITE>(Board& board, MoveList* list);
 template void generateMoves<ALL_MOVES, BLACK>(Board& board, MoveList* list);
 
 template void generateMoves<CAPTURE, WHITE>(Board& board, MoveList* list);
-template void generateMoves<CAPTURE, BLACK>(Board& board, MoveList* list);
\ No newline at end of file
+template void generateMoves<CAPTURE, BLACK>(Board& board, MoveList* list);
+
+template void generateMoves<QUIET, WHITE>(Board& board, MoveList* list);
+template void generateMoves<QUIET, BLACK>(Board& board, MoveList* list);
\ No newline at end of file
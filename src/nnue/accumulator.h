@@ -24,6 +24,15 @@ struct Accumulator
     alignas(64) int32_t psqt[8];
 };
 
+/**
+ * @brief An accumulator of one perspective for one king bucket, and the pieces it was computed for
+ */
+struct AccumulatorCacheEntry
+{
+    Accumulator acc;
+    Bitboard pieces[2][6]; // [color][piece type - 1]
+};
+
 struct AccumulatorNode
 {
     Accumulator whiteAcc, blackAcc;
@@ -0,0 +1,78 @@
+#include "accumulatorCache.h"
+
+#include "../board.h"
+#include "../piece.h"
+#include "nnue.h"
+
+AccumulatorCache::AccumulatorCache(const NNUE* network) : network(network)
+{
+    // every entry starts as an empty board
+    entries = new (std::align_val_t(64)) AccumulatorCacheEntry[2][NUM_KING_BUCKETS][2]{};
+    for (int perspective = 0; perspective < 2; perspective++)
+        for (int bucket = 0; bucket < NUM_KING_BUCKETS; bucket++)
+            for (int mirrored = 0; mirrored < 2; mirrored++)
+                network->Reset(entries[perspective][bucket][mirrored].acc);
+}
+
+AccumulatorCache::~AccumulatorCache()
+{
+    operator delete[](entries, std::align_val_t(64));
+}
+
+void AccumulatorCache::Refresh(const Board& board, Color perspective, Accumulator& acc)
+{
+    const bool whitePOV = perspective == WHITE;
+    const Square kingSquare = lsb(board.getBB(perspective, KING));
+    const bool mirrored = getFile(kingSquare) > FILE_D;
+
+    AccumulatorCacheEntry& entry = entries[!whitePOV][GetKingBucket(kingSquare, whitePOV)][mirrored];
+
+    int adds[MAX_UPDATE_FEATURES];
+    int subs[MAX_UPDATE_FEATURES];
+    int numAdds = 0, numSubs = 0;
+
+    // at most 32 pieces can be added (all the pieces on the board) or removed (all the pieces of the entry)
+    for (Color color : {WHITE, BLACK})
+    {
+        for (PieceType type = PAWN; type <= KING; type = static_cast<PieceType>(type + 1))
+        {
+            const Piece piece = makePiece(type, color);
+            const Bitboard cached = entry.pieces[color == BLACK][type - 1];
+            const Bitboard current = board.getBB(color, type);
+
+            Bitboard added = current & ~cached;
+            Bitboard removed = cached & ~current;
+
+            while (added)
+                adds[numAdds++] = GetIndex(popLSB(added), kingSquare, piece, whitePOV);
+            while (removed)
+                subs[numSubs++] = GetIndex(popLSB(removed), kingSquare, piece, whitePOV);
+        }
+    }
+
+    // the entry may be from an unrelated position, then starting over from the biases costs fewer rows
+    const int numPieces = popCount(board.getBB(ALL_PIECES));
+    if (numAdds + numSubs > numPieces)
+    {
+        network->Reset(entry.acc);
+
+        numAdds = numSubs = 0;
+        for (Color color : {WHITE, BLACK})
+        {
+            for (PieceType type = PAWN; type <= KING; type = static_cast<PieceType>(type + 1))
+            {
+                const Piece piece = makePiece(type, color);
+                Bitboard pieces = board.getBB(color, type);
+                while (pieces)
+                    adds[numAdds++] = GetIndex(popLSB(pieces), kingSquare, piece, whitePOV);
+            }
+        }
+    }
+
+    for (Color color : {WHITE, BLACK})
+        for (PieceType type = PAWN; type <= KING; type = static_cast<PieceType>(type + 1))
+            entry.pieces[color == BLACK][type - 1] = board.getBB(color, type);
+
+    network->Update(entry.acc, entry.acc, adds, numAdds, subs, numSubs);
+    acc = entry.acc;
+}
@@ -0,0 +1,38 @@
+#ifndef ACCUMULATOR_CACHE_H
+#define ACCUMULATOR_CACHE_H
+
+#include "../types.h"
+#include "accumulator.h"
+#include "halfkav2_hm.h"
+
+/**
+ * @brief Refresh cache ("Finny table"): for every perspective and king bucket, the last accumulator computed and the
+ * pieces it was computed for. A full refresh starts from the entry of the same king bucket, so only the pieces that
+ * changed since it was last used have to be added or removed
+ */
+class AccumulatorCache
+{
+  public:
+    AccumulatorCache(const NNUE* network);
+    ~AccumulatorCache();
+
+    AccumulatorCache(const AccumulatorCache&) = delete;
+    AccumulatorCache& operator=(const AccumulatorCache&) = delete;
+
+    /**
+     * @brief Computes the accumulator of one perspective from scratch
+     *
+     * @param board the position
+     * @param perspective the perspective
+     * @param acc receives the accumulator
+     */
+    void Refresh(const Board& board, Color perspective, Accumulator& acc);
+
+  private:
+    const NNUE* network;
+
+    // indexed [perspective][king bucket][mirrored]
+    AccumulatorCacheEntry (*entries)[NUM_KING_BUCKETS][2];
+};
+
+#endif
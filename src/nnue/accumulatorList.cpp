@@ -4,188 +4,158 @@
 #include "../piece.h"
 #include "nnue.h"
 
-AccumulatorList::AccumulatorList() : last(0)
+AccumulatorList::AccumulatorList(const NNUE* network) : network(network), last(0), refreshCache(network)
 {
     accumulators = new (std::align_val_t(64)) AccumulatorNode[MAX_DEPTH]{};
 }
 
 AccumulatorList::~AccumulatorList()
 {
-    operator delete(accumulators, std::align_val_t(64));
+    operator delete[](accumulators, std::align_val_t(64));
 }
 
-void AccumulatorList::ComputeAccumulator(const Board& board)
+namespace
 {
-    Square whiteKingSquare = lsb(board.getBB(WHITE, KING));
-    Square blackKingSquare = lsb(board.getBB(BLACK, KING));
-
-    int lastComputedBlack = last;
-    int lastComputedWhite = last;
-    bool needsFullRefreshBlack = false;
-
-    // check if full refresh is needed
-    while (lastComputedBlack >= 0 && !accumulators[lastComputedBlack].isBlackComputed && !needsFullRefreshBlack)
-    {
-        needsFullRefreshBlack = accumulators[lastComputedBlack--].dirtyMove.movePiece == makePiece(KING, BLACK);
-    }
-
-    assert(lastComputedBlack >= 0);
-
-    auto& accumulatorNode = accumulators[last];
-    auto& blackComputed = accumulators[lastComputedBlack];
-
-    if (needsFullRefreshBlack)
-    {
-        board.ResetBlackAccumulator(accumulatorNode.blackAcc);
-    }
-    else
+    /**
+     * @brief The indexes added to and removed from an accumulator over a chain of moves
+     */
+    struct FeatureDelta
     {
-        /*
-            Possible optimization for "smart-updating" the nnue. It minimizes adds and removes.
-            Smartly updating the accumulator happens in two stages:
-            1. Add new dirty pieces to the accumulator
-            2. Remove old dirty pieces from the accumulator
-
-            The idea for computing follows these rules:
-            1. When coming across an untracked dirty piece (new dirty piece), we add it to the current accumulator.
-            Captured pieces will be treated as dirty pieces, but aren't added them to the accumulator
-            3. When coming across a tracked dirty piece, update it's position on the piece table so we can find it's
-           origin at the last computed accumulator
-            4. When reaching the previous computed accumulator, remove all the tracked pieces from the current
-           accumulator
-        */
-        Accumulator& acc = accumulatorNode.blackAcc;
-        acc = blackComputed.blackAcc;
-
-        int current = last;
-
-        while (current != lastComputedBlack)
+        int adds[MAX_UPDATE_FEATURES];
+        int subs[MAX_UPDATE_FEATURES];
+        int numAdds = 0;
+        int numSubs = 0;
+
+        // a piece that is added and later removed (or the other way around) doesn't change the accumulator, so the
+        // pair cancels out instead of costing two rows
+        static bool Cancel(int* list, int& count, int index)
         {
-
-            const auto& dirtyMove = accumulators[current].dirtyMove;
-            if (dirtyMove.movePiece == EMPTY) // null-move
+            for (int i = 0; i < count; i++)
             {
-                current--;
-                continue;
+                if (list[i] == index)
+                {
+                    list[i] = list[--count];
+                    return true;
+                }
             }
+            return false;
+        }
 
-            Piece fromPiece, toPiece;
-            fromPiece = dirtyMove.movePiece;
+        void Add(int index)
+        {
+            if (!Cancel(subs, numSubs, index))
+                adds[numAdds++] = index;
+        }
 
-            if (dirtyMove.promote == EMPTY)
-            {
-                toPiece = fromPiece;
-            }
-            else
-            {
-                toPiece = dirtyMove.promote;
-            }
+        void Sub(int index)
+        {
+            if (!Cancel(adds, numAdds, index))
+                subs[numSubs++] = index;
+        }
 
-            int fromIndex = GetIndex(dirtyMove.from, blackKingSquare, fromPiece, false);
-            int toIndex = GetIndex(dirtyMove.to, blackKingSquare, toPiece, false);
+        // true if there is not enough room left for another move (at most 2 adds and 2 subs)
+        bool IsFull() const
+        {
+            return numAdds > MAX_UPDATE_FEATURES - 2 || numSubs > MAX_UPDATE_FEATURES - 2;
+        }
+    };
+} // namespace
 
-            if (dirtyMove.castleFrom != SQ_NONE)
-            {
-                Piece rook = makePiece(ROOK, getColor(fromPiece));
-                int castleFrom = GetIndex(dirtyMove.castleFrom, blackKingSquare, rook, false);
-                int castleTo = GetIndex(dirtyMove.castleTo, blackKingSquare, rook, false);
-                nnue->AddAddSubSub(acc, toIndex, castleTo, fromIndex, castleFrom);
-            }
-            else if (dirtyMove.capturedPiece != EMPTY)
-            {
-                int captureIndex = GetIndex(dirtyMove.captured, blackKingSquare, dirtyMove.capturedPiece, false);
-                nnue->AddSubSub(acc, toIndex, fromIndex, captureIndex);
-            }
-            else
-            {
-                nnue->AddSub(acc, toIndex, fromIndex);
-            }
+void AccumulatorList::ComputeAccumulator(const Board& board)
+{
+    ComputePerspective(board, BLACK);
+    ComputePerspective(board, WHITE);
 
-            current--;
-        }
-    }
+#ifdef VERIFY_ACCUMULATOR
+    const auto& accumulatorNode = accumulators[last];
+    Accumulator refWhite, refBlack;
+    board.ResetWhiteAccumulator(*network, refWhite);
+    board.ResetBlackAccumulator(*network, refBlack);
+    assert(std::memcmp(refWhite.data, accumulatorNode.whiteAcc.data, sizeof(refWhite.data)) == 0);
+    assert(std::memcmp(refBlack.data, accumulatorNode.blackAcc.data, sizeof(refBlack.data)) == 0);
+    assert(std::memcmp(refWhite.psqt, accumulatorNode.whiteAcc.psqt, sizeof(refWhite.psqt)) == 0);
+    assert(std::memcmp(refBlack.psqt, accumulatorNode.blackAcc.psqt, sizeof(refBlack.psqt)) == 0);
+#endif
+}
 
-    accumulatorNode.isBlackComputed = true;
+void AccumulatorList::ComputePerspective(const Board& board, Color perspective)
+{
+    const bool whitePOV = perspective == WHITE;
+    const Square kingSquare = lsb(board.getBB(perspective, KING));
+    const Piece king = makePiece(KING, perspective);
 
-    bool needsFullRefreshWhite = false;
+    auto isComputed = [whitePOV](const AccumulatorNode& node) {
+        return whitePOV ? node.isWhiteComputed : node.isBlackComputed;
+    };
 
-    // check if full refresh is needed
-    while (lastComputedWhite >= 0 && !accumulators[lastComputedWhite].isWhiteComputed && !needsFullRefreshWhite)
+    int lastComputed = last;
+    bool needsFullRefresh = false;
+
+    // find the last computed accumulator, a king move of this side in between needs a full refresh
+    while (lastComputed >= 0 && !isComputed(accumulators[lastComputed]) && !needsFullRefresh)
     {
-        needsFullRefreshWhite = accumulators[lastComputedWhite--].dirtyMove.movePiece == makePiece(KING, WHITE);
+        needsFullRefresh = accumulators[lastComputed--].dirtyMove.movePiece == king;
     }
 
-    assert(lastComputedWhite >= 0);
+    assert(lastComputed >= 0);
 
-    auto& whiteComputed = accumulators[lastComputedWhite];
+    AccumulatorNode& accumulatorNode = accumulators[last];
+    Accumulator& acc = whitePOV ? accumulatorNode.whiteAcc : accumulatorNode.blackAcc;
 
-    if (needsFullRefreshWhite)
+    if (needsFullRefresh)
     {
-        board.ResetWhiteAccumulator(accumulatorNode.whiteAcc);
+        refreshCache.Refresh(board, perspective, acc);
     }
-    else
+    else if (lastComputed != last)
     {
-        Accumulator& acc = accumulatorNode.whiteAcc;
-        acc = whiteComputed.whiteAcc;
-
+        /*
+            All the moves between the last computed accumulator and the current one are gathered into a single list of
+            added and removed features, which is applied in one pass: the accumulator is read and written once no
+            matter how many plies behind it is. A piece that moves several times only leaves its first origin and
+            final destination in the list, since the squares in between cancel out.
+        */
+        const AccumulatorNode& computedNode = accumulators[lastComputed];
+        const Accumulator* src = whitePOV ? &computedNode.whiteAcc : &computedNode.blackAcc;
 
-        int current = last;
+        FeatureDelta delta;
 
-        while (current != lastComputedWhite)
+        for (int current = last; current != lastComputed; current--)
         {
-
             const auto& dirtyMove = accumulators[current].dirtyMove;
             if (dirtyMove.movePiece == EMPTY) // null-move
-            {
-                current--;
                 continue;
-            }
-
-            Piece fromPiece, toPiece;
-            fromPiece = dirtyMove.movePiece;
 
-            if (dirtyMove.promote == EMPTY)
-            {
-                toPiece = fromPiece;
-            }
-            else
-            {
-                toPiece = dirtyMove.promote;
-            }
+            const Piece fromPiece = dirtyMove.movePiece;
+            const Piece toPiece = dirtyMove.promote == EMPTY ? fromPiece : dirtyMove.promote;
 
-            int fromIndex = GetIndex(dirtyMove.from, whiteKingSquare, fromPiece, true);
-            int toIndex = GetIndex(dirtyMove.to, whiteKingSquare, toPiece, true);
+            delta.Add(GetIndex(dirtyMove.to, kingSquare, toPiece, whitePOV));
+            delta.Sub(GetIndex(dirtyMove.from, kingSquare, fromPiece, whitePOV));
 
             if (dirtyMove.castleFrom != SQ_NONE)
             {
                 Piece rook = makePiece(ROOK, getColor(fromPiece));
-                int castleFrom = GetIndex(dirtyMove.castleFrom, whiteKingSquare, rook, true);
-                int castleTo = GetIndex(dirtyMove.castleTo, whiteKingSquare, rook, true);
-                nnue->AddAddSubSub(acc, toIndex, castleTo, fromIndex, castleFrom);
+                delta.Add(GetIndex(dirtyMove.castleTo, kingSquare, rook, whitePOV));
+                delta.Sub(GetIndex(dirtyMove.castleFrom, kingSquare, rook, whitePOV));
             }
             else if (dirtyMove.capturedPiece != EMPTY)
             {
-                int captureIndex = GetIndex(dirtyMove.captured, whiteKingSquare, dirtyMove.capturedPiece, true);
-                nnue->AddSubSub(acc, toIndex, fromIndex, captureIndex);
+                delta.Sub(GetIndex(dirtyMove.captured, kingSquare, dirtyMove.capturedPiece, whitePOV));
             }
-            else
+
+            // very long chains are applied in several passes
+            if (delta.IsFull())
             {
-                nnue->AddSub(acc, toIndex, fromIndex);
+                network->Update(*src, acc, delta.adds, delta.numAdds, delta.subs, delta.numSubs);
+                src = &acc;
+                delta.numAdds = delta.numSubs = 0;
             }
-
-            current--;
         }
-    }
 
-    accumulatorNode.isWhiteComputed = true;
+        network->Update(*src, acc, delta.adds, delta.numAdds, delta.subs, delta.numSubs);
+    }
 
-#ifdef VERIFY_ACCUMULATOR
-    Accumulator refWhite, refBlack;
-    board.ResetWhiteAccumulator(refWhite);
-    board.ResetBlackAccumulator(refBlack);
-    assert(std::memcmp(refWhite.data, accumulatorNode.whiteAcc.data, sizeof(refWhite.data)) == 0);
-    assert(std::memcmp(refBlack.data, accumulatorNode.blackAcc.data, sizeof(refBlack.data)) == 0);
-    assert(std::memcmp(refWhite.psqt, accumulatorNode.whiteAcc.psqt, sizeof(refWhite.psqt)) == 0);
-    assert(std::memcmp(refBlack.psqt, accumulatorNode.blackAcc.psqt, sizeof(refBlack.psqt)) == 0);
-#endif
-}
\ No newline at end of file
+    if (whitePOV)
+        accumulatorNode.isWhiteComputed = true;
+    else
+        accumulatorNode.isBlackComputed = true;
+}
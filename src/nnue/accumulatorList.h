@@ -3,13 +3,18 @@
 
 #include "../types.h"
 #include "accumulator.h"
+#include "accumulatorCache.h"
+#include "halfkav2_hm.h"
 
 class AccumulatorList
 {
   public:
-    AccumulatorList();
+    AccumulatorList(const NNUE* network);
     ~AccumulatorList();
 
+    AccumulatorList(const AccumulatorList&) = delete;
+    AccumulatorList& operator=(const AccumulatorList&) = delete;
+
     void ComputeAccumulator(const Board& board);
 
     inline AccumulatorNode& Current()
@@ -22,9 +27,23 @@ class AccumulatorList
         last = cur;
     }
 
+    inline const NNUE& GetNetwork() const
+    {
+        return *network;
+    }
+
   private:
+    /**
+     * @brief Brings the current accumulator of one perspective up to date, either incrementally from the last computed
+     * accumulator or with a full refresh if that side's king moved in between
+     */
+    void ComputePerspective(const Board& board, Color perspective);
+
+    const NNUE* network;
     AccumulatorNode* accumulators;
     int last;
+
+    AccumulatorCache refreshCache;
 };
 
 #endif
\ No newline at end of file
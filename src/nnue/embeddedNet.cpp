@@ -0,0 +1,55 @@
+#include "embeddedNet.h"
+
+#ifndef DEFAULT_EVALFILE
+#define DEFAULT_EVALFILE "nnue02.bin"
+#endif
+
+#ifdef EMBEDDED_NET_PATH
+
+#if defined(_WIN32) || defined(_WIN64)
+#define EMBEDDED_NET_SECTION ".section .rdata,\"dr\"\n"
+#else
+#define EMBEDDED_NET_SECTION ".section .rodata\n"
+#endif
+
+// the assembler copies the file into the read-only data, where the OS maps it straight from the executable
+asm(EMBEDDED_NET_SECTION
+    ".balign 64\n"
+    ".global pioneerEmbeddedNet\n"
+    "pioneerEmbeddedNet:\n"
+    ".incbin \"" EMBEDDED_NET_PATH "\"\n"
+    ".global pioneerEmbeddedNetEnd\n"
+    "pioneerEmbeddedNetEnd:\n"
+    ".previous\n");
+
+extern "C" const unsigned char pioneerEmbeddedNet[];
+extern "C" const unsigned char pioneerEmbeddedNetEnd[];
+
+const void* EmbeddedNetData()
+{
+    return pioneerEmbeddedNet;
+}
+
+size_t EmbeddedNetSize()
+{
+    return pioneerEmbeddedNetEnd - pioneerEmbeddedNet;
+}
+
+#else
+
+const void* EmbeddedNetData()
+{
+    return nullptr;
+}
+
+size_t EmbeddedNetSize()
+{
+    return 0;
+}
+
+#endif
+
+const char* DefaultEvalFile()
+{
+    return DEFAULT_EVALFILE;
+}
@@ -0,0 +1,29 @@
+#ifndef EMBEDDEDNET_H
+#define EMBEDDEDNET_H
+
+#include <cstddef>
+
+/**
+ * @brief Gets the network embedded in the executable at build time (see PIONEER_EMBED_NET in CMakeLists.txt). The build
+ * converts it to the native format first and aligns it to 64 bytes, so it is used in place
+ *
+ * @return const void* nullptr if the executable was built without a network
+ */
+const void* EmbeddedNetData();
+
+/**
+ * @brief Gets the size of the embedded network in bytes, 0 if there is none
+ *
+ * @return size_t
+ */
+size_t EmbeddedNetSize();
+
+/**
+ * @brief Gets the file name of the default network, the default value of the EvalFile option. The embedded network if
+ * there is one, otherwise the file of that name in nnue_bin next to the executable
+ *
+ * @return const char*
+ */
+const char* DefaultEvalFile();
+
+#endif
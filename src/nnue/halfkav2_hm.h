@@ -8,6 +8,22 @@
 #include <cassert>
 
 #define NUM_FEATURES 22528
+#define NUM_KING_BUCKETS 32
+
+/**
+ * @brief Gets the king bucket GetIndex uses for a king square: the square mirrored to files A-D and seen from the given
+ * side. Together with whether the king was mirrored it determines the index of every piece
+ */
+constexpr int GetKingBucket(Square king_square, const bool whitePOV)
+{
+    if (getFile(king_square) > FILE_D)
+        king_square = getSquare(FILE_H - getFile(king_square), getRank(king_square));
+
+    if (!whitePOV)
+        king_square ^= 56;
+
+    return king_square - int(king_square / 8) * 4;
+}
 
 constexpr int GetIndex(Square square, Square king_square, const Piece piece, const bool whitePOV)
 {
@@ -0,0 +1,54 @@
+#include "../cpu.h"
+#include "kernels.h"
+
+// the tiers compiled by CMakeLists.txt, each defines Kernels::<tier>::kernels in its own copy of kernels.cpp
+#ifdef PIONEER_NATIVE
+namespace Kernels::Native
+{
+    extern const NNUEKernels kernels;
+}
+#define BASELINE_KERNELS Kernels::Native::kernels
+#else
+namespace Kernels::Sse41
+{
+    extern const NNUEKernels kernels;
+}
+namespace Kernels::Avx2
+{
+    extern const NNUEKernels kernels;
+}
+namespace Kernels::Avx512
+{
+    extern const NNUEKernels kernels;
+}
+namespace Kernels::Avx512Vnni
+{
+    extern const NNUEKernels kernels;
+}
+#define BASELINE_KERNELS Kernels::Sse41::kernels
+#endif
+
+const NNUEKernels* activeKernels = &BASELINE_KERNELS;
+
+void InitKernels()
+{
+#ifdef PIONEER_NATIVE
+    // built for the host with -march=native, there is nothing to choose from
+    activeKernels = &Kernels::Native::kernels;
+#else
+    const CpuFeatures& cpu = GetCpuFeatures();
+
+    // the features each tier is compiled with, see the KERNEL_FLAGS in CMakeLists.txt
+    const bool avx2 = cpu.avx2 && cpu.fma && cpu.bmi1 && cpu.bmi2;
+    const bool avx512 = avx2 && cpu.avx512f && cpu.avx512bw && cpu.avx512dq && cpu.avx512vl;
+
+    if (avx512 && cpu.avx512vnni)
+        activeKernels = &Kernels::Avx512Vnni::kernels;
+    else if (avx512)
+        activeKernels = &Kernels::Avx512::kernels;
+    else if (avx2)
+        activeKernels = &Kernels::Avx2::kernels;
+    else
+        activeKernels = &Kernels::Sse41::kernels;
+#endif
+}
@@ -0,0 +1,209 @@
+// This file is compiled once per instruction set tier, with KERNEL_TIER set to the tier's namespace and the tier's
+// compiler flags (see CMakeLists.txt). Everything in it must live in the tier's namespace: an inline function shared
+// with other translation units would be merged by the linker into a single copy, possibly one using instructions the
+// CPU doesn't have.
+#ifndef KERNEL_TIER
+#error "kernels.cpp must be compiled with KERNEL_TIER defined"
+#endif
+
+#define SIMD_NAMESPACE KERNEL_TIER
+#include "../SIMD.h"
+#include "kernels.h"
+#include "subnet.h"
+#include <algorithm>
+
+namespace Kernels
+{
+namespace KERNEL_TIER
+{
+    /**
+     * @brief Scales a hidden layer's sum and clips it to [0, max], the activation the next layer expects
+     */
+    inline int8_t ClipOutput(int32_t sum, int scale, int32_t max)
+    {
+        int32_t x = (sum + scale / 2) / scale; // Round to nearest integer
+        x = x < 0 ? 0 : x;
+        return static_cast<int8_t>(x > max ? max : x);
+    }
+
+    /**
+     * @brief Propagates the first hidden layer. Only the weight columns of the non-zero 4 byte input chunks are
+     * accumulated, see SparseLayer
+     */
+    template <typename L>
+    void ForwardSparse(const L& layer, const Accumulator& us, const Accumulator& them, int8_t* output)
+    {
+        static_assert(L::out_size * 4 % sizeof(SIMD::vec_t) == 0, "A column block must fill whole vectors");
+
+        constexpr int NUM_REGS = L::out_size * 4 / sizeof(SIMD::vec_t);
+        constexpr int NUM_SUMS = 4;
+
+        alignas(64) int8_t sqrCReLU[L::in_size];
+
+        SIMD::SqrCReLU(us.data, sqrCReLU, L::max, L::in_size);
+        SIMD::SqrCReLU(them.data, sqrCReLU + L::in_size / 2, L::max, L::in_size);
+
+        uint16_t nonZero[L::num_chunks + 8];
+        const int numNonZero = SIMD::findNonZeroChunks(sqrCReLU, L::in_size, nonZero);
+
+        // consecutive chunks go to independent sums so the additions don't form a single dependency chain
+        SIMD::vec_t sums[NUM_SUMS][NUM_REGS];
+        for (int j = 0; j < NUM_SUMS; j++)
+            for (int r = 0; r < NUM_REGS; r++)
+                sums[j][r] = SIMD::vecZero();
+
+        const int32_t* input32 = reinterpret_cast<const int32_t*>(sqrCReLU);
+
+        int k = 0;
+        for (; k + NUM_SUMS <= numNonZero; k += NUM_SUMS)
+        {
+            for (int j = 0; j < NUM_SUMS; j++)
+            {
+                const int chunk = nonZero[k + j];
+                const SIMD::vec_t input = SIMD::vecBroadcast32(input32[chunk]);
+                const int8_t* column = layer.weights[chunk][0];
+                for (int r = 0; r < NUM_REGS; r++)
+                    sums[j][r] = SIMD::vecDpbusd32(sums[j][r], input, SIMD::loadVec(column + r * sizeof(SIMD::vec_t)));
+            }
+        }
+        for (; k < numNonZero; k++)
+        {
+            const int chunk = nonZero[k];
+            const SIMD::vec_t input = SIMD::vecBroadcast32(input32[chunk]);
+            const int8_t* column = layer.weights[chunk][0];
+            for (int r = 0; r < NUM_REGS; r++)
+                sums[0][r] = SIMD::vecDpbusd32(sums[0][r], input, SIMD::loadVec(column + r * sizeof(SIMD::vec_t)));
+        }
+
+        alignas(64) int32_t dots[L::out_size];
+        for (int r = 0; r < NUM_REGS; r++)
+        {
+            SIMD::vec_t sum = sums[0][r];
+            for (int j = 1; j < NUM_SUMS; j++)
+                sum = SIMD::vecAdd32(sum, sums[j][r]);
+            SIMD::storeVec(reinterpret_cast<int8_t*>(dots) + r * sizeof(SIMD::vec_t), sum);
+        }
+
+        for (size_t o = 0; o < L::out_size; o++)
+            output[o] = ClipOutput(layer.biases[o] + dots[o], L::scale, L::max);
+    }
+
+    /**
+     * @brief Propagates a small hidden layer from inputs in [0, 127], see HiddenLayer
+     */
+    template <typename L>
+    void ForwardHidden(const L& layer, const int8_t* input, int8_t* output)
+    {
+        static_assert(L::out_size * 4 % sizeof(SIMD::vec_t) == 0, "A column block must fill whole vectors");
+
+        constexpr int NUM_REGS = L::out_size * 4 / sizeof(SIMD::vec_t);
+
+        SIMD::vec_t sums[NUM_REGS];
+        for (int r = 0; r < NUM_REGS; r++)
+            sums[r] = SIMD::loadVec(reinterpret_cast<const int8_t*>(layer.biases) + r * sizeof(SIMD::vec_t));
+
+        const int32_t* input32 = reinterpret_cast<const int32_t*>(input);
+
+        for (size_t chunk = 0; chunk < L::num_chunks; chunk++)
+        {
+            const SIMD::vec_t in = SIMD::vecBroadcast32(input32[chunk]);
+            const int8_t* column = layer.weights[chunk][0];
+            for (int r = 0; r < NUM_REGS; r++)
+                sums[r] = SIMD::vecDpbusd32(sums[r], in, SIMD::loadVec(column + r * sizeof(SIMD::vec_t)));
+        }
+
+        alignas(64) int32_t outputs[L::out_size];
+        for (int r = 0; r < NUM_REGS; r++)
+            SIMD::storeVec(reinterpret_cast<int8_t*>(outputs) + r * sizeof(SIMD::vec_t), sums[r]);
+
+        for (size_t o = 0; o < L::out_size; o++)
+            output[o] = ClipOutput(outputs[o], L::scale, L::max);
+    }
+
+    /**
+     * @brief Propagates a small hidden layer for several positions, see HiddenLayer. The weights are loaded into
+     * registers once and reused for every position, a small matrix-matrix product
+     */
+    template <typename L>
+    void ForwardHiddenBatch(const L& layer, const int8_t (*input)[L::in_size], int8_t (*output)[L::out_size], int count)
+    {
+        constexpr int NUM_REGS = L::out_size * 4 / sizeof(SIMD::vec_t);
+
+        SIMD::vec_t weights[L::num_chunks][NUM_REGS];
+        SIMD::vec_t biases[NUM_REGS];
+        for (size_t chunk = 0; chunk < L::num_chunks; chunk++)
+            for (int r = 0; r < NUM_REGS; r++)
+                weights[chunk][r] = SIMD::loadVec(layer.weights[chunk][0] + r * sizeof(SIMD::vec_t));
+        for (int r = 0; r < NUM_REGS; r++)
+            biases[r] = SIMD::loadVec(reinterpret_cast<const int8_t*>(layer.biases) + r * sizeof(SIMD::vec_t));
+
+        for (int p = 0; p < count; p++)
+        {
+            const int32_t* input32 = reinterpret_cast<const int32_t*>(input[p]);
+
+            SIMD::vec_t sums[NUM_REGS];
+            for (int r = 0; r < NUM_REGS; r++)
+                sums[r] = biases[r];
+
+            for (size_t chunk = 0; chunk < L::num_chunks; chunk++)
+            {
+                const SIMD::vec_t in = SIMD::vecBroadcast32(input32[chunk]);
+                for (int r = 0; r < NUM_REGS; r++)
+                    sums[r] = SIMD::vecDpbusd32(sums[r], in, weights[chunk][r]);
+            }
+
+            alignas(64) int32_t outputs[L::out_size];
+            for (int r = 0; r < NUM_REGS; r++)
+                SIMD::storeVec(reinterpret_cast<int8_t*>(outputs) + r * sizeof(SIMD::vec_t), sums[r]);
+
+            for (size_t o = 0; o < L::out_size; o++)
+                output[p][o] = ClipOutput(outputs[o], L::scale, L::max);
+        }
+    }
+
+    /**
+     * @brief Propagates the output layer from inputs in [0, 127], see OutputLayer
+     */
+    template <typename L>
+    int32_t ForwardOutput(const L& layer, const int8_t* input)
+    {
+        return layer.biases[0] + SIMD::dotProduct8Short(input, layer.weights, L::in_size);
+    }
+
+    int32_t ForwardSubnet(const Subnet& subnet, const Accumulator& us, const Accumulator& them)
+    {
+        alignas(64) int8_t hidden1_output[decltype(subnet.hidden1)::out_size];
+        alignas(64) int8_t hidden2_output[decltype(subnet.hidden2)::out_size];
+        ForwardSparse(subnet.hidden1, us, them, hidden1_output);
+        ForwardHidden(subnet.hidden2, hidden1_output, hidden2_output);
+        return ForwardOutput(subnet.hidden3, hidden2_output);
+    }
+
+    void ForwardSubnetBatch(const Subnet& subnet, const Accumulator* const* us, const Accumulator* const* them,
+                            int count, int32_t* outputs)
+    {
+        // small enough for the activations to stay in L1
+        constexpr int TILE_SIZE = 32;
+
+        alignas(64) int8_t hidden1_output[TILE_SIZE][decltype(subnet.hidden1)::out_size];
+        alignas(64) int8_t hidden2_output[TILE_SIZE][decltype(subnet.hidden2)::out_size];
+
+        for (int start = 0; start < count; start += TILE_SIZE)
+        {
+            const int n = std::min(TILE_SIZE, count - start);
+
+            // the inputs of the first layer are sparse and differ for every position, it stays one position at a time
+            for (int p = 0; p < n; p++)
+                ForwardSparse(subnet.hidden1, *us[start + p], *them[start + p], hidden1_output[p]);
+
+            ForwardHiddenBatch(subnet.hidden2, hidden1_output, hidden2_output, n);
+
+            for (int p = 0; p < n; p++)
+                outputs[start + p] = ForwardOutput(subnet.hidden3, hidden2_output[p]);
+        }
+    }
+
+    extern const NNUEKernels kernels;
+    const NNUEKernels kernels = {KERNEL_TIER_NAME, SIMD::addSubRows16, ForwardSubnet, ForwardSubnetBatch};
+} // namespace KERNEL_TIER
+} // namespace Kernels
@@ -0,0 +1,47 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "accumulator.h"
+#include <cstdint>
+
+struct Subnet;
+
+/**
+ * @brief The NNUE kernels compiled for one instruction set tier. kernels.cpp is compiled once per tier with that tier's
+ * compiler flags (see CMakeLists.txt) and the fastest tier the CPU supports is selected at startup, so one binary runs
+ * at full speed on any x86-64-v2 machine
+ */
+struct NNUEKernels
+{
+    const char* name;
+
+    // dst = src + adds[0] + ... - subs[0] - ... for n 16 bit values, src and dst may be the same
+    void (*addSubRows16)(const int16_t* src, int16_t* dst, const int16_t* const* adds, int numAdds,
+                         const int16_t* const* subs, int numSubs, int n);
+
+    // output of a subnet in units of 1 / hidden3.scale
+    int32_t (*forwardSubnet)(const Subnet& subnet, const Accumulator& us, const Accumulator& them);
+
+    // outputs[i] = forwardSubnet(subnet, *us[i], *them[i]) for count positions
+    void (*forwardSubnetBatch)(const Subnet& subnet, const Accumulator* const* us, const Accumulator* const* them,
+                               int count, int32_t* outputs);
+};
+
+extern const NNUEKernels* activeKernels;
+
+/**
+ * @brief Selects the fastest kernels the CPU supports, called once at startup
+ */
+void InitKernels();
+
+/**
+ * @brief Gets the selected kernels
+ *
+ * @return const NNUEKernels&
+ */
+inline const NNUEKernels& ActiveKernels()
+{
+    return *activeKernels;
+}
+
+#endif
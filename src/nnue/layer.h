@@ -6,7 +6,6 @@
 
 #include "accumulator.h"
 #include "halfkav2_hm.h"
-#include "../SIMD.h"
 
 template <typename W_T, typename B_T, size_t IN, size_t OUT, int SCALE = 64, int32_t MAX = 127, bool IS_INPUT = false>
 struct Layer
@@ -26,64 +25,79 @@ struct Layer
     // Layer parameters
     alignas(64) weight_t weights[row][column];
     alignas(64) bias_t biases[out_size];
+};
 
-    constexpr int32_t CReLU(const int32_t x, const int32_t max) const
-    {
-        return std::min(std::max(x, 0), max);
-    }
-
-    inline void Forward(const Accumulator& us, const Accumulator& them, int32_t* output) const
-    {
-        static_assert(!isInputLayer, "Cannot call forward on input layer!");
-
-        alignas(32) int8_t sqrCReLU[in_size];
-
-        SIMD::SqrCReLU(us.data, sqrCReLU, max, in_size);
-        SIMD::SqrCReLU(them.data, sqrCReLU + in_size / 2, max, in_size);
-
-        for (uint32_t i = 0; i < out_size; i++)
-        {
-            const int8_t* __restrict w = weights[i];
+/**
+ * @brief The first hidden layer, fed by the squared clipped accumulators. Most of its inputs are zero after the
+ * activation, so only the columns of the non-zero inputs are accumulated. The weights are stored column-interleaved: the
+ * OUT weights of each group of 4 inputs are contiguous, so a non-zero group reads one block of OUT * 4 bytes
+ */
+template <size_t IN, size_t OUT, int SCALE = 64, int32_t MAX = 127>
+struct SparseLayer
+{
+    static constexpr size_t in_size = IN;
+    static constexpr size_t out_size = OUT;
+    static constexpr size_t num_chunks = IN / 4;
+    static constexpr int scale = SCALE;
+    static constexpr int half_scale = SCALE / 2;
+    static constexpr int32_t max = MAX;
 
-            int32_t sum = biases[i];
-            
-            sum += SIMD::dotProduct8(sqrCReLU, w, in_size / 2);
-            sum += SIMD::dotProduct8(sqrCReLU + in_size / 2, w + in_size / 2, in_size / 2);
+    // Layer parameters, weights[chunk][output][i] is the weight of input chunk * 4 + i for that output
+    alignas(64) int8_t weights[num_chunks][out_size][4];
+    alignas(64) int32_t biases[out_size];
 
-            output[i] = (sum + half_scale) / scale; // Round to nearest integer
-        }
+    /**
+     * @brief Sets the weights from the usual row-major [OUT][IN] layout
+     */
+    void SetWeights(const int8_t (&dense)[OUT][IN])
+    {
+        for (size_t o = 0; o < out_size; o++)
+            for (size_t i = 0; i < in_size; i++)
+                weights[i / 4][o][i % 4] = dense[o][i];
     }
+};
 
-    inline void Forward(const int32_t* input, int32_t* output) const
-    {
-        static_assert(!isInputLayer, "Cannot call forward on input layer!");
+/**
+ * @brief A small fully connected layer between hidden layers. The inputs are few enough that every input chunk is
+ * broadcast and multiplied against its column block, using the same column-interleaved layout as SparseLayer
+ */
+template <size_t IN, size_t OUT, int SCALE = 64, int32_t MAX = 127>
+struct HiddenLayer
+{
+    static constexpr size_t in_size = IN;
+    static constexpr size_t out_size = OUT;
+    static constexpr size_t num_chunks = IN / 4;
+    static constexpr int scale = SCALE;
+    static constexpr int32_t max = MAX;
 
-        for (size_t i = 0; i < out_size; i++)
-        {
-            int32_t sum = biases[i];
-            for (size_t j = 0; j < in_size; j++)
-            {
-                sum += static_cast<int32_t>(weights[i][j]) * CReLU(input[j], max);
-            }
-            output[i] = (sum + half_scale) / scale; // Round to nearest integer
-        }
-    }
+    // Layer parameters, weights[chunk][output][i] is the weight of input chunk * 4 + i for that output
+    alignas(64) int8_t weights[num_chunks][out_size][4];
+    alignas(64) int32_t biases[out_size];
 
-    inline void Forwardf(const int32_t* input, float* output) const
+    /**
+     * @brief Sets the weights from the usual row-major [OUT][IN] layout
+     */
+    void SetWeights(const int8_t (&dense)[OUT][IN])
     {
-        static_assert(!isInputLayer, "Cannot call forward on input layer!");
-
-        for (size_t i = 0; i < out_size; i++)
-        {
-            int32_t sum = biases[i];
-            for (size_t j = 0; j < in_size; j++)
-            {
-                sum += static_cast<int32_t>(weights[i][j]) * CReLU(input[j], max);
-            }
-            output[i] = static_cast<float>(sum) / static_cast<float>(scale);
-        }
+        for (size_t o = 0; o < out_size; o++)
+            for (size_t i = 0; i < in_size; i++)
+                weights[i / 4][o][i % 4] = dense[o][i];
     }
 };
 
+/**
+ * @brief The last layer, a single output. The result is returned unscaled (in units of 1 / SCALE) so the caller can
+ * combine it with the psqt term before rounding once
+ */
+template <size_t IN, int SCALE = 64>
+struct OutputLayer
+{
+    static constexpr size_t in_size = IN;
+    static constexpr int scale = SCALE;
+
+    // Layer parameters
+    alignas(64) int8_t weights[in_size];
+    alignas(64) int32_t biases[1];
+};
 
 #endif // LAYER_H
\ No newline at end of file
@@ -1,10 +1,223 @@
 #include "nnue.h"
 #include "../board.h"
 #include "../color.h"
+#include "../largeAlloc.h"
+#include "../mappedFile.h"
+#include "accumulatorCache.h"
+#include "embeddedNet.h"
+#include "kernels.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Header of a native network file, padded to 64 bytes so the parameters after it stay aligned when the file is
+ * mapped
+ */
+struct NNUEFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;     // of the parameters, sizeof(NNUE) of the engine that wrote the file
+    uint64_t checksum; // of the parameters, see Checksum
+    uint8_t reserved[40];
+};
+
+static_assert(sizeof(NNUEFileHeader) == 64, "The parameters must stay 64 byte aligned");
+static_assert(std::is_trivially_copyable_v<NNUE>, "Native files store the NNUE object as is");
+static_assert(sizeof(NNUE) % sizeof(uint64_t) == 0, "Checksum works on whole 64 bit words");
+
+/**
+ * @brief 64 bit FNV-1a over whole words, enough to catch truncated or corrupted files
+ */
+static uint64_t Checksum(const void* data, size_t size)
+{
+    const uint64_t* words = static_cast<const uint64_t*>(data);
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < size / sizeof(uint64_t); i++)
+        hash = (hash ^ words[i]) * 0x100000001B3ULL;
+    return hash;
+}
+
+/**
+ * @brief Checks the header of a native file and the checksum of the parameters following it
+ *
+ * @param header the header
+ * @param params the parameters, sizeof(NNUE) bytes
+ * @param filename for the error messages
+ * @return bool true if the parameters can be used
+ */
+static bool CheckNativeFile(const NNUEFileHeader& header, const void* params, const std::string& filename)
+{
+    if (header.version != NNUE_FILE_VERSION || header.size != sizeof(NNUE))
+    {
+        std::cerr << "Error: " << filename << " is a native network file for another engine version (format version "
+                  << header.version << ", expected " << NNUE_FILE_VERSION << "). Convert it again from the trainer's "
+                  << "file." << std::endl;
+        return false;
+    }
+
+    if (Checksum(params, sizeof(NNUE)) != header.checksum)
+    {
+        std::cerr << "Error: checksum mismatch in " << filename << ", the file is corrupted." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Read-only stream over memory, so an embedded network is read like a file
+ */
+class MemoryBuffer : public std::streambuf
+{
+  public:
+    MemoryBuffer(const void* data, size_t size)
+    {
+        char* begin = const_cast<char*>(static_cast<const char*>(data));
+        setg(begin, begin, begin + size);
+    }
+
+  protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) override
+    {
+        char* base = dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr();
+        if (off < eback() - base || off > egptr() - base)
+            return pos_type(off_type(-1));
+
+        setg(eback(), base + off, egptr());
+        return pos_type(gptr() - eback());
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+std::shared_ptr<const NNUE> NNUE::LoadShared(const std::string& filename)
+{
+    static std::mutex mtx;
+    static std::map<std::string, std::weak_ptr<const NNUE>> loaded;
+
+    std::lock_guard lock(mtx);
+
+    std::shared_ptr<const NNUE> network = loaded[filename].lock();
+    if (network)
+        return network;
+
+    network = Map(filename);
+    if (network)
+    {
+        std::cout << "info string NNUE: " << sizeof(NNUE) / (1024 * 1024) << " MB (memory mapped)" << std::endl;
+
+        loaded[filename] = network;
+        return network;
+    }
+
+    LargeAllocation memory;
+    std::shared_ptr<NNUE> newNetwork = MakeSharedLarge<NNUE>(&memory);
+    if (!newNetwork)
+    {
+        std::cerr << "Failed to allocate memory for the NNUE network." << std::endl;
+        return nullptr;
+    }
+
+    if (!newNetwork->Load(filename))
+    {
+        std::cerr << "Failed to load NNUE network." << std::endl;
+        return nullptr;
+    }
+
+    std::cout << "info string NNUE: " << sizeof(NNUE) / (1024 * 1024) << " MB (" << LargeAllocDescription(memory)
+              << ")" << std::endl;
+
+    loaded[filename] = newNetwork;
+    return newNetwork;
+}
 
-NNUE* nnue = new NNUE;
+std::shared_ptr<const NNUE> NNUE::LoadEmbedded()
+{
+    static std::mutex mtx;
+    static std::weak_ptr<const NNUE> embedded;
+
+    if (!EmbeddedNetSize())
+        return nullptr;
+
+    std::lock_guard lock(mtx);
+
+    std::shared_ptr<const NNUE> network = embedded.lock();
+    if (network)
+        return network;
+
+    // the executable's data lives as long as the process, there is nothing to free
+    if (const NNUE* params = NativeParams(EmbeddedNetData(), EmbeddedNetSize()))
+    {
+        std::cout << "info string NNUE: " << sizeof(NNUE) / (1024 * 1024) << " MB (embedded)" << std::endl;
+
+        network = std::shared_ptr<const NNUE>(params, [](const NNUE*) {});
+        embedded = network;
+        return network;
+    }
+
+    LargeAllocation memory;
+    std::shared_ptr<NNUE> newNetwork = MakeSharedLarge<NNUE>(&memory);
+    if (!newNetwork)
+    {
+        std::cerr << "Failed to allocate memory for the NNUE network." << std::endl;
+        return nullptr;
+    }
+
+    MemoryBuffer buffer(EmbeddedNetData(), EmbeddedNetSize());
+    std::istream params(&buffer);
+    if (!newNetwork->Load(params, "the embedded network"))
+    {
+        std::cerr << "Failed to load NNUE network." << std::endl;
+        return nullptr;
+    }
+
+    std::cout << "info string NNUE: " << sizeof(NNUE) / (1024 * 1024) << " MB (" << LargeAllocDescription(memory)
+              << ")" << std::endl;
+
+    embedded = newNetwork;
+    return newNetwork;
+}
+
+const NNUE* NNUE::NativeParams(const void* data, size_t size)
+{
+    // anything that isn't a valid native file is left to Load, which reports what is wrong with it
+    const NNUEFileHeader* header = static_cast<const NNUEFileHeader*>(data);
+    if (size != sizeof(NNUEFileHeader) + sizeof(NNUE) || header->magic != NNUE_FILE_MAGIC ||
+        header->version != NNUE_FILE_VERSION || header->size != sizeof(NNUE) ||
+        Checksum(header + 1, sizeof(NNUE)) != header->checksum)
+        return nullptr;
+
+    // the data is 64 byte aligned and so is the header's size, so the parameters are as aligned as a real NNUE object
+    return reinterpret_cast<const NNUE*>(header + 1);
+}
+
+std::shared_ptr<const NNUE> NNUE::Map(const std::string& filename)
+{
+    MappedFile file = MapFile(filename);
+    if (!file.ptr)
+        return nullptr;
+
+    const NNUE* network = NativeParams(file.ptr, file.size);
+    if (!network)
+    {
+        UnmapFile(file);
+        return nullptr;
+    }
+
+    std::cout << "info string NNUE parameters: " << sizeof(NNUE) << " bytes mapped from " << filename << std::endl;
+
+    return std::shared_ptr<const NNUE>(network, [file](const NNUE*) { UnmapFile(file); });
+}
 
 bool NNUE::Load(const std::string& filename)
 {
@@ -16,6 +229,78 @@ bool NNUE::Load(const std::string& filename)
         return false;
     }
 
+    return Load(params, filename);
+}
+
+bool NNUE::Load(std::istream& params, const std::string& filename)
+{
+    NNUEFileHeader header = {};
+    params.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!params || header.magic != NNUE_FILE_MAGIC)
+    {
+        // no header, a file straight from the trainer
+        params.clear();
+        params.seekg(0);
+        return LoadTrainerFormat(params, filename);
+    }
+
+    params.read(reinterpret_cast<char*>(this), sizeof(NNUE));
+    if (!params)
+    {
+        std::cerr << "Error: " << filename << " is truncated." << std::endl;
+        return false;
+    }
+
+    if (!CheckNativeFile(header, this, filename))
+        return false;
+
+    std::cout << "info string NNUE parameters: " << sizeof(NNUE) << " bytes loaded from " << filename << std::endl;
+    return true;
+}
+
+bool NNUE::Save(const std::string& filename) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Error: Could not create " << filename << std::endl;
+        return false;
+    }
+
+    NNUEFileHeader header = {};
+    header.magic = NNUE_FILE_MAGIC;
+    header.version = NNUE_FILE_VERSION;
+    header.size = sizeof(NNUE);
+    header.checksum = Checksum(this, sizeof(NNUE));
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(this), sizeof(NNUE));
+    file.close();
+
+    if (!file)
+    {
+        std::cerr << "Error: Could not write " << filename << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool NNUE::Convert(const std::string& input, const std::string& output)
+{
+    // far too big for the stack
+    std::shared_ptr<NNUE> network = MakeSharedLarge<NNUE>();
+    if (!network)
+    {
+        std::cerr << "Failed to allocate memory for the NNUE network." << std::endl;
+        return false;
+    }
+
+    return network->Load(input) && network->Save(output);
+}
+
+bool NNUE::LoadTrainerFormat(std::istream& params, const std::string& filename)
+{
     // Load using old [1024+NUM_SUBNETS][NUM_FEATURES] layout
     using OrigInputLayer = Layer<int16_t, int16_t, InputLayer::in_size, InputLayer::out_size, 64, 127, false>;
     auto* temp = new OrigInputLayer;
@@ -29,10 +314,13 @@ bool NNUE::Load(const std::string& filename)
 
     delete temp;
 
+    // hidden1 and hidden2 are stored row-major in the file and interleaved for the kernels
     for (uint32_t i = 0; i < 8; i++)
     {
         auto& subnet = subnets[i];
-        params.read(reinterpret_cast<char*>(subnet.hidden1.weights), sizeof(subnet.hidden1.weights));
+        int8_t dense[decltype(subnet.hidden1)::out_size][decltype(subnet.hidden1)::in_size];
+        params.read(reinterpret_cast<char*>(dense), sizeof(dense));
+        subnet.hidden1.SetWeights(dense);
     }
     for (uint32_t i = 0; i < 8; i++)
     {
@@ -43,7 +331,9 @@ bool NNUE::Load(const std::string& filename)
     for (uint32_t i = 0; i < 8; i++)
     {
         auto& subnet = subnets[i];
-        params.read(reinterpret_cast<char*>(subnet.hidden2.weights), sizeof(subnet.hidden2.weights));
+        int8_t dense[decltype(subnet.hidden2)::out_size][decltype(subnet.hidden2)::in_size];
+        params.read(reinterpret_cast<char*>(dense), sizeof(dense));
+        subnet.hidden2.SetWeights(dense);
     }
     for (uint32_t i = 0; i < 8; i++)
     {
@@ -65,8 +355,8 @@ bool NNUE::Load(const std::string& filename)
     size_t paramsSize = params.tellg();
     params.seekg(0, std::ios::end);
     size_t fileSize = params.tellg();
-    std::cout << "NNUE parameters: " << paramsSize << " bytes loaded from " << filename << " - file size: " << fileSize
-              << std::endl;
+    std::cout << "info string NNUE parameters: " << paramsSize << " bytes loaded from " << filename
+              << " - file size: " << fileSize << std::endl;
 
     if (paramsSize != fileSize)
     {
@@ -78,118 +368,189 @@ bool NNUE::Load(const std::string& filename)
     return true;
 }
 
-float NNUE::Evaluate(const Board& board, const Accumulator& us, const Accumulator& them) const
+/**
+ * @brief Converts a network value to centipawns. The value is in units of 1 / denominator of the network's output range,
+ * where 127 is 500 centipawns. Rounds to nearest, halfway cases away from zero
+ */
+static Score ToCentipawns(int64_t value, int64_t denominator)
+{
+    const int64_t numerator = value * 500;
+    denominator *= 127;
+    return numerator >= 0 ? (numerator + denominator / 2) / denominator
+                          : -((-numerator + denominator / 2) / denominator);
+}
+
+/**
+ * @brief Gets the subnet (and psqt bucket) used for a position, by piece count
+ */
+static uint32_t SubnetIndex(const Board& board)
 {
     int numPieces = popCount(board.getBB(ALL_PIECES));
     uint32_t index = (numPieces - 2) / 4;
 
     assert(index >= 0 && index < 8); // Ensure index is within bounds
-
-    float psqt = (us.psqt[index] - them.psqt[index]) / 2.0f;
-    float output = Forward(index, us, them);
-    return (output + psqt) * 500.0f / 127.0f;
+    return index;
 }
 
-float NNUE::Forward(int subnet, const Accumulator& us, const Accumulator& them) const
+/**
+ * @brief Combines a subnet's output and the psqt difference into the final score
+ */
+static Score FinalScore(int32_t output, int32_t psqt)
 {
-    // Feed the accumulators through the specified subnet and return the final evaluation
-    return subnets[subnet].Forward(us, them);
+    // the output is in units of 1 / scale and the psqt in units of 1 / 2, bring the psqt to the output's scale
+    constexpr int outputScale = decltype(Subnet::hidden3)::scale;
+    return ToCentipawns(output + int64_t(psqt) * (outputScale / 2), outputScale);
 }
 
-float NNUE::FastEvaluate(const Board& board, const Accumulator& us, const Accumulator& them) const
+Score NNUE::Evaluate(const Board& board, const Accumulator& us, const Accumulator& them) const
 {
-    int numPieces = popCount(board.getBB(ALL_PIECES));
-    uint32_t index = (numPieces - 2) / 4;
-
-    assert(index >= 0 && index < 8); // Ensure index is within bounds
+    uint32_t index = SubnetIndex(board);
 
-    float psqt = (us.psqt[index] - them.psqt[index]) / 2.0f;
-    return psqt * 500.0f / 127.0f;
+    int32_t psqt = us.psqt[index] - them.psqt[index];
+    int32_t output = Forward(index, us, them);
+    return FinalScore(output, psqt);
 }
 
-void NNUE::Add(Accumulator& acc, int add) const
+void NNUE::EvaluateBatch(const Board* boards, size_t count, Score* scores) const
 {
-    constexpr size_t dataSize = sizeof(Accumulator::data) / sizeof(Accumulator::data[0]);
-    constexpr size_t psqtSize = sizeof(Accumulator::psqt) / sizeof(Accumulator::psqt[0]);
-
-    const int16_t* addW = inputLayer.weights[add];
-    for (uint32_t i = 0; i < dataSize; i++)
+    // everything is local to the call, several threads can evaluate batches at the same time
+    AccumulatorCache cache(this);
+    std::unique_ptr<Accumulator[]> whiteAccs(new Accumulator[BATCH_BLOCK_SIZE]);
+    std::unique_ptr<Accumulator[]> blackAccs(new Accumulator[BATCH_BLOCK_SIZE]);
+
+    /*
+        The positions are visited sorted by king buckets, so positions sharing the same refresh cache entries follow
+        each other and only their differences are applied to the accumulators, then by subnet. The sort is stable:
+        consecutive positions of a game stay together and differ by a move or two.
+    */
+    std::vector<uint32_t> keys(count);
+    std::vector<uint32_t> order(count);
+    for (size_t i = 0; i < count; i++)
     {
-        acc.data[i] += addW[i];
+        const Square whiteKing = lsb(boards[i].getBB(WHITE, KING));
+        const Square blackKing = lsb(boards[i].getBB(BLACK, KING));
+        const uint32_t whiteBucket = GetKingBucket(whiteKing, true) << 1 | (getFile(whiteKing) > FILE_D);
+        const uint32_t blackBucket = GetKingBucket(blackKing, false) << 1 | (getFile(blackKing) > FILE_D);
+        keys[i] = (whiteBucket << 6 | blackBucket) << 3 | SubnetIndex(boards[i]);
+        order[i] = (uint32_t)i;
     }
-    for (uint32_t i = 0; i < psqtSize; i++)
+    std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+    int blockOrder[BATCH_BLOCK_SIZE];
+    const Accumulator* us[BATCH_BLOCK_SIZE];
+    const Accumulator* them[BATCH_BLOCK_SIZE];
+    int32_t outputs[BATCH_BLOCK_SIZE];
+
+    for (size_t start = 0; start < count; start += BATCH_BLOCK_SIZE)
     {
-        acc.psqt[i] += addW[i + dataSize];
+        const int n = (int)std::min<size_t>(BATCH_BLOCK_SIZE, count - start);
+        const uint32_t* block = order.data() + start;
+
+        for (int k = 0; k < n; k++)
+        {
+            const Board& board = boards[block[k]];
+            cache.Refresh(board, WHITE, whiteAccs[k]);
+            cache.Refresh(board, BLACK, blackAccs[k]);
+        }
+
+        // the block spans several king buckets, each subnet propagates all its positions while its weights are in cache
+        auto subnetOf = [&](int k) { return keys[block[k]] & 7; };
+        for (int k = 0; k < n; k++)
+            blockOrder[k] = k;
+        std::stable_sort(blockOrder, blockOrder + n, [&](int a, int b) { return subnetOf(a) < subnetOf(b); });
+
+        for (int j = 0; j < n; j++)
+        {
+            const int k = blockOrder[j];
+            const bool whiteToMove = boards[block[k]].whiteToMove;
+            us[j] = whiteToMove ? &whiteAccs[k] : &blackAccs[k];
+            them[j] = whiteToMove ? &blackAccs[k] : &whiteAccs[k];
+        }
+
+        for (int j = 0; j < n;)
+        {
+            const uint32_t index = subnetOf(blockOrder[j]);
+
+            int end = j + 1;
+            while (end < n && subnetOf(blockOrder[end]) == index)
+                end++;
+
+            ActiveKernels().forwardSubnetBatch(subnets[index], us + j, them + j, end - j, outputs + j);
+            for (int i = j; i < end; i++)
+                scores[block[blockOrder[i]]] = FinalScore(outputs[i], us[i]->psqt[index] - them[i]->psqt[index]);
+
+            j = end;
+        }
     }
 }
 
-void NNUE::Sub(Accumulator& acc, int sub) const
+int32_t NNUE::Forward(int subnet, const Accumulator& us, const Accumulator& them) const
 {
-    constexpr size_t dataSize = sizeof(Accumulator::data) / sizeof(Accumulator::data[0]);
-    constexpr size_t psqtSize = sizeof(Accumulator::psqt) / sizeof(Accumulator::psqt[0]);
+    // Feed the accumulators through the specified subnet and return the final evaluation
+    return subnets[subnet].Forward(us, them);
+}
 
-    const int16_t* subW = inputLayer.weights[sub];
-    for (uint32_t i = 0; i < dataSize; i++)
-    {
-        acc.data[i] -= subW[i];
-    }
-    for (uint32_t i = 0; i < psqtSize; i++)
-    {
-        acc.psqt[i] -= subW[i + dataSize];
-    }
+Score NNUE::FastEvaluate(const Board& board, const Accumulator& us, const Accumulator& them) const
+{
+    uint32_t index = SubnetIndex(board);
+
+    return ToCentipawns(us.psqt[index] - them.psqt[index], 2);
 }
 
-void NNUE::AddSub(Accumulator& acc, int add, int sub) const
+void NNUE::Add(Accumulator& acc, int add) const
 {
-    constexpr size_t dataSize = sizeof(Accumulator::data) / sizeof(Accumulator::data[0]);
-    constexpr size_t psqtSize = sizeof(Accumulator::psqt) / sizeof(Accumulator::psqt[0]);
+    Update(acc, acc, &add, 1, nullptr, 0);
+}
 
-    const int16_t* addW = inputLayer.weights[add];
-    const int16_t* subW = inputLayer.weights[sub];
-    for (uint32_t i = 0; i < dataSize; i++)
-    {
-        acc.data[i] += addW[i] - subW[i];
-    }
-    for (uint32_t i = 0; i < psqtSize; i++)
-    {
-        acc.psqt[i] += addW[i + dataSize] - subW[i + dataSize];
-    }
+void NNUE::Sub(Accumulator& acc, int sub) const
+{
+    Update(acc, acc, nullptr, 0, &sub, 1);
 }
 
-void NNUE::AddSubSub(Accumulator& acc, int add, int sub1, int sub2) const
-{    
-    constexpr size_t dataSize = sizeof(Accumulator::data) / sizeof(Accumulator::data[0]);
-    constexpr size_t psqtSize = sizeof(Accumulator::psqt) / sizeof(Accumulator::psqt[0]);
+void NNUE::AddSub(Accumulator& acc, int add, int sub) const
+{
+    Update(acc, acc, &add, 1, &sub, 1);
+}
 
-    const int16_t* addW = inputLayer.weights[add];
-    const int16_t* sub1W = inputLayer.weights[sub1];
-    const int16_t* sub2W = inputLayer.weights[sub2];
-    for (uint32_t i = 0; i < dataSize; i++)
-    {
-        acc.data[i] += addW[i] - sub1W[i] - sub2W[i];
-    }
-    for (uint32_t i = 0; i < psqtSize; i++)
-    {
-        acc.psqt[i] += addW[i + dataSize] - sub1W[i + dataSize] - sub2W[i + dataSize];
-    }
+void NNUE::AddSubSub(Accumulator& acc, int add, int sub1, int sub2) const
+{
+    const int subs[] = {sub1, sub2};
+    Update(acc, acc, &add, 1, subs, 2);
 }
 
 void NNUE::AddAddSubSub(Accumulator& acc, int add1, int add2, int sub1, int sub2) const
+{
+    const int adds[] = {add1, add2};
+    const int subs[] = {sub1, sub2};
+    Update(acc, acc, adds, 2, subs, 2);
+}
+
+void NNUE::Update(const Accumulator& src, Accumulator& dst, const int* adds, int numAdds, const int* subs,
+                  int numSubs) const
 {
     constexpr size_t dataSize = sizeof(Accumulator::data) / sizeof(Accumulator::data[0]);
     constexpr size_t psqtSize = sizeof(Accumulator::psqt) / sizeof(Accumulator::psqt[0]);
 
-    const int16_t* add1W = inputLayer.weights[add1];
-    const int16_t* add2W = inputLayer.weights[add2];
-    const int16_t* sub1W = inputLayer.weights[sub1];
-    const int16_t* sub2W = inputLayer.weights[sub2];
-    for (uint32_t i = 0; i < dataSize; i++)
-    {
-        acc.data[i] += add1W[i] + add2W[i] - sub1W[i] - sub2W[i];
-    }
+    assert(numAdds <= MAX_UPDATE_FEATURES && numSubs <= MAX_UPDATE_FEATURES);
+
+    const int16_t* addRows[MAX_UPDATE_FEATURES];
+    const int16_t* subRows[MAX_UPDATE_FEATURES];
+    for (int i = 0; i < numAdds; i++)
+        addRows[i] = inputLayer.weights[adds[i]];
+    for (int i = 0; i < numSubs; i++)
+        subRows[i] = inputLayer.weights[subs[i]];
+
+    ActiveKernels().addSubRows16(src.data, dst.data, addRows, numAdds, subRows, numSubs, dataSize);
+
+    // the psqt values are accumulated in 32 bits, too few to be worth vectorizing
     for (uint32_t i = 0; i < psqtSize; i++)
     {
-        acc.psqt[i] += add1W[i + dataSize] + add2W[i + dataSize] - sub1W[i + dataSize] - sub2W[i + dataSize];
+        int32_t psqt = src.psqt[i];
+        for (int j = 0; j < numAdds; j++)
+            psqt += addRows[j][i + dataSize];
+        for (int j = 0; j < numSubs; j++)
+            psqt -= subRows[j][i + dataSize];
+        dst.psqt[i] = psqt;
     }
 }
 
@@ -4,11 +4,23 @@
 #include "../types.h"
 #include "layer.h"
 #include "subnet.h"
+#include <iosfwd>
+#include <memory>
 #include <string>
 #include <vector>
 
 #define NUM_SUBNETS 8
 
+// maximum number of added (and of removed) indexes in a single NNUE::Update call
+#define MAX_UPDATE_FEATURES 32
+
+// positions evaluated together by NNUE::EvaluateBatch, their accumulators should fit in L2
+#define BATCH_BLOCK_SIZE 256
+
+// native network files: a 64 byte header followed by the NNUE object exactly as it is laid out in memory
+#define NNUE_FILE_MAGIC 0x554E4E50 // "PNNU" little endian
+#define NNUE_FILE_VERSION 1        // bump whenever the memory layout of NNUE changes
+
 using InputLayer = Layer<int16_t, int16_t, NUM_FEATURES, 1024 + NUM_SUBNETS, 64, 127, true>;
 
 
@@ -19,21 +31,56 @@ class NNUE
     ~NNUE() = default;
 
     /**
-     * Loads the NNUE parameters from a file. The file should be in a specific format, with the input layer parameters
-     * followed by the subnet parameters. Returns true if the parameters were successfully loaded, false otherwise.
+     * Loads the NNUE parameters from a file, either in the native format (see Save) or in the trainer's format, with
+     * the input layer parameters followed by the subnet parameters, which is converted to the runtime layout. Returns
+     * true if the parameters were successfully loaded, false otherwise.
      */
     bool Load(const std::string& filename);
 
     /**
-     * Evaluates the given board position using the NNUE
+     * Saves the parameters in the native format: a versioned header with a checksum, followed by the parameters in
+     * their runtime layout, so the file can be mapped into memory and used as is. Returns true on success.
+     */
+    bool Save(const std::string& filename) const;
+
+    /**
+     * Returns a read-only network loaded from the given file, or nullptr if it can't be loaded. Networks are shared: as
+     * long as one instance loaded from a file is alive, further calls with the same file return that instance instead
+     * of loading another copy. Native files are mapped read-only instead of being read, so all the engine processes on
+     * a machine share one copy in the OS page cache and there is nothing to convert at startup.
+     */
+    static std::shared_ptr<const NNUE> LoadShared(const std::string& filename);
+
+    /**
+     * Returns the network embedded in the executable, or nullptr if it was built without one (or it can't be
+     * loaded). A native network is used in place, straight from the executable's read-only data.
+     */
+    static std::shared_ptr<const NNUE> LoadEmbedded();
+
+    /**
+     * Converts a network in the trainer's format to the native format. Returns true on success.
+     */
+    static bool Convert(const std::string& input, const std::string& output);
+
+    /**
+     * Evaluates the given board position using the NNUE, in centipawns. The whole pipeline is integer: the subnet
+     * output and the psqt are combined in fixed point and rounded once
+     */
+    Score Evaluate(const Board& board, const Accumulator& us, const Accumulator& them) const;
+
+    /**
+     * Evaluates many independent positions, scores[i] is Evaluate of boards[i] (from the side to move's perspective).
+     * The positions are processed in blocks: within a block they are sorted by subnet and king squares, so the
+     * accumulators are refreshed from similar positions (see AccumulatorCache) and each subnet runs over all its
+     * positions at once while its weights are in cache. Safe to call from several threads at the same time.
      */
-    float Evaluate(const Board& board, const Accumulator& us, const Accumulator& them) const;
+    void EvaluateBatch(const Board* boards, size_t count, Score* scores) const;
 
     /**
      * Evaluates the given board position using the NNUE using only the psqt values (much faster but much less
      * positional information)
      */
-    float FastEvaluate(const Board& board, const Accumulator& us, const Accumulator& them) const;
+    Score FastEvaluate(const Board& board, const Accumulator& us, const Accumulator& them) const;
 
     /**
      * Adds the contribution of the given index to the accumulator.
@@ -55,24 +102,50 @@ class NNUE
 
     void AddAddSubSub(Accumulator& acc, int add1, int add2, int sub1, int sub2) const;
 
+    /**
+     * Sets dst to src plus the contributions of the added indexes minus the contributions of the removed indexes. All
+     * the indexes are applied in a single pass over the accumulator, so batching the changes of several moves into one
+     * call reads and writes the accumulator only once. src and dst may be the same accumulator.
+     */
+    void Update(const Accumulator& src, Accumulator& dst, const int* adds, int numAdds, const int* subs,
+                int numSubs) const;
+
     /**
      * Resets the accumulator to the initial state (only biases)
      */
     void Reset(Accumulator& acc) const;
 
   private:
+    /**
+     * Loads the parameters from a stream in either format, see Load(const std::string&)
+     */
+    bool Load(std::istream& params, const std::string& filename);
+
+    /**
+     * Loads the parameters in the trainer's format, transposing the input layer and interleaving the hidden layers
+     */
+    bool LoadTrainerFormat(std::istream& params, const std::string& filename);
+
+    /**
+     * Gets the parameters of a native file image if it is a valid native file, nullptr otherwise
+     */
+    static const NNUE* NativeParams(const void* data, size_t size);
+
+    /**
+     * Maps a native file, returns nullptr if the file is not a valid native file
+     */
+    static std::shared_ptr<const NNUE> Map(const std::string& filename);
+
     /**
      * Feeds the accumulators through the subnets and returns the final evaluation. The "us" accumulator should contain
      * the contributions of our pieces, while the "them" accumulator should contain the contributions of the opponent's
      * pieces.
      */
-    float Forward(int subnet, const Accumulator& us, const Accumulator& them) const;
+    int32_t Forward(int subnet, const Accumulator& us, const Accumulator& them) const;
 
     // transposed so inputLayer is accessed [1024 + NUM_SUBNETS][NUM_FEATURES] (so it's optimized for cache)
     InputLayer inputLayer;
     Subnet subnets[NUM_SUBNETS];
 };
 
-extern NNUE* nnue;
-
 #endif // NNUE_H
\ No newline at end of file
@@ -1,22 +1,98 @@
 #include "perft.h"
 #include "movegen.h"
 
-unsigned long long perft(Board& board, unsigned int depth)
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <thread>
+
+PerftTable::PerftTable(unsigned long long megabytes) : buckets(nullptr), numBuckets(0), memory()
 {
+    assert(megabytes != 0);
 
-    MoveList moves;
-    board.generateMoves<ALL_MOVES>(&moves);
+    // halve the size until the allocation succeeds
+    for (; megabytes > 0 && !buckets; megabytes /= 2)
+    {
+        numBuckets = megabytes * 1024ULL * 1024ULL / sizeof(Bucket);
+        memory = LargeAlloc(numBuckets * sizeof(Bucket));
+        buckets = static_cast<Bucket*>(memory.ptr);
+    }
 
-    if (depth == 1)
+    // the owner checks IsAllocated and runs without a table
+    if (!buckets)
+        numBuckets = 0;
+}
+
+PerftTable::~PerftTable()
+{
+    LargeFree(memory);
+}
+
+bool PerftTable::Probe(Key key, unsigned int depth, unsigned long long& count)
+{
+    key = DepthKey(key, depth);
+
+    for (Slot& slot : GetBucket(key)->slots)
     {
-        return moves.GetSize();
+        const uint64_t stored = slot.count.load(std::memory_order_relaxed);
+        if ((slot.keyXorCount.load(std::memory_order_relaxed) ^ stored) == key)
+        {
+            count = stored;
+            return true;
+        }
     }
-    else if (depth == 0)
+
+    return false;
+}
+
+void PerftTable::Store(Key key, unsigned int depth, unsigned long long count)
+{
+    key = DepthKey(key, depth);
+
+    // the smallest subtree is the cheapest to recompute, an empty slot counts as the smallest
+    Slot* replace = nullptr;
+    uint64_t replaceCount = UINT64_MAX;
+    for (Slot& slot : GetBucket(key)->slots)
     {
-        return 1;
+        const uint64_t stored = slot.count.load(std::memory_order_relaxed);
+        const Key storedKey = slot.keyXorCount.load(std::memory_order_relaxed) ^ stored;
+        if (storedKey == key || (!storedKey && !stored))
+        {
+            replace = &slot;
+            break;
+        }
+
+        if (stored < replaceCount)
+        {
+            replace = &slot;
+            replaceCount = stored;
+        }
     }
 
+    replace->keyXorCount.store(key ^ count, std::memory_order_relaxed);
+    replace->count.store(count, std::memory_order_relaxed);
+}
+
+void PerftTable::Clear()
+{
+    std::memset(static_cast<void*>(buckets), 0, numBuckets * sizeof(Bucket));
+}
+
+unsigned long long perft(Board& board, unsigned int depth, PerftTable* table)
+{
+    if (depth == 0)
+        return 1;
+
+    // counting the moves of a depth 1 node is cheaper than a probe, only deeper subtrees are in the table
     unsigned long long moveCount = 0;
+    if (depth > 1 && table && table->Probe(board.getHash(), depth, moveCount))
+        return moveCount;
+
+    MoveList moves;
+    board.generateMoves<ALL_MOVES>(&moves);
+
+    if (depth == 1)
+        return moves.GetSize();
 
     BoardState state;
     DirtyMove dirtyMove;
@@ -24,9 +100,105 @@ unsigned long long perft(Board& board, unsigned int depth)
     for (Move* m = moves.moves; m < moves.end; m++)
     {
         board.makeMove(*m, &state, dirtyMove);
-        moveCount += perft(board, depth - 1);
+        moveCount += perft(board, depth - 1, table);
         board.undoMove();
     }
 
+    if (table)
+        table->Store(board.getHash(), depth, moveCount);
+
     return moveCount;
+}
+
+unsigned long long PerftDivide(const Board& board, unsigned int depth, unsigned int threads, PerftTable* table,
+                               std::vector<std::pair<Move, unsigned long long>>* divide)
+{
+    // a subtree to count: a root move, and a reply to it unless the split is at the root
+    struct PerftTask
+    {
+        unsigned int root;
+        Move reply;
+    };
+
+    Board root = board;
+    BoardState rootState;
+    DirtyMove dirtyMove;
+
+    MoveList rootMoves;
+    root.generateMoves<ALL_MOVES>(&rootMoves);
+    const unsigned int numRoots = rootMoves.GetSize();
+
+    if (divide)
+        divide->clear();
+
+    if (depth == 0)
+        return 1;
+
+    // a single root move has too little work for the threads to share, split below the replies instead
+    const bool splitReplies = depth >= 3;
+    std::vector<PerftTask> tasks;
+    for (unsigned int i = 0; i < numRoots; i++)
+    {
+        if (!splitReplies)
+        {
+            tasks.push_back({i, 0});
+            continue;
+        }
+
+        root.makeMove(rootMoves.moves[i], &rootState, dirtyMove);
+        MoveList replies;
+        root.generateMoves<ALL_MOVES>(&replies);
+        for (Move* m = replies.moves; m < replies.end; m++)
+            tasks.push_back({i, *m});
+        root.undoMove();
+    }
+
+    std::vector<std::atomic<unsigned long long>> counts(numRoots);
+    std::atomic<size_t> nextTask(0);
+
+    auto worker = [&]() {
+        // every thread walks its own copy, the states below the root are only read
+        Board local = root;
+        BoardState states[2];
+        DirtyMove dirty;
+
+        for (size_t t = nextTask++; t < tasks.size(); t = nextTask++)
+        {
+            const PerftTask& task = tasks[t];
+            local.makeMove(rootMoves.moves[task.root], &states[0], dirty);
+
+            unsigned long long count;
+            if (splitReplies)
+            {
+                local.makeMove(task.reply, &states[1], dirty);
+                count = perft(local, depth - 2, table);
+                local.undoMove();
+            }
+            else
+                count = perft(local, depth - 1, table);
+
+            local.undoMove();
+            counts[task.root] += count;
+        }
+    };
+
+    threads = std::max(1u, std::min<unsigned int>(threads, std::max<size_t>(tasks.size(), 1)));
+    std::vector<std::thread> helpers;
+    for (unsigned int i = 1; i < threads; i++)
+        helpers.emplace_back(worker);
+
+    worker();
+
+    for (std::thread& t : helpers)
+        t.join();
+
+    unsigned long long total = 0;
+    for (unsigned int i = 0; i < numRoots; i++)
+    {
+        total += counts[i];
+        if (divide)
+            divide->emplace_back(rootMoves.moves[i], counts[i]);
+    }
+
+    return total;
 }
\ No newline at end of file
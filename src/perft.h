@@ -1,8 +1,114 @@
 #ifndef PERFT_H
 #define PERFT_H
 
+#include <atomic>
+#include <utility>
+#include <vector>
+
 #include "board.h"
+#include "largeAlloc.h"
+
+#define PERFT_BUCKET_SIZE 4
+
+/**
+ * @brief A transposition table for perft, mapping a position and a depth to the number of leaf nodes below it. Like the
+ * search's TT every slot stores the key xor'ed with the count next to the count, so it is shared by all perft threads
+ * without locks and a slot torn by two threads writing at the same time is seen as a miss
+ */
+class PerftTable
+{
+  public:
+    /**
+     * @brief Construct a new Perft Table. If the size can't be allocated smaller sizes are tried, if none fits the table
+     * is left empty and IsAllocated returns false
+     *
+     * @param megabytes the size of the table, at least 1
+     */
+    PerftTable(unsigned long long megabytes);
+    ~PerftTable();
+
+    PerftTable(const PerftTable&) = delete;
+    PerftTable& operator=(const PerftTable&) = delete;
+
+    /**
+     * @brief Looks up the number of leaf nodes below a position
+     *
+     * @param key zobrist hash of the position
+     * @param depth remaining depth
+     * @param count receives the number of leaf nodes if found
+     * @return true if the position was found at this depth
+     */
+    bool Probe(Key key, unsigned int depth, unsigned long long& count);
+
+    /**
+     * @brief Stores the number of leaf nodes below a position, replacing the smallest subtree of the bucket if it is
+     * full
+     */
+    void Store(Key key, unsigned int depth, unsigned long long count);
+
+    void Clear();
+
+    inline bool IsAllocated() const
+    {
+        return buckets != nullptr;
+    }
+
+    inline unsigned long long GetSizeMB() const
+    {
+        return numBuckets * sizeof(Bucket) / (1024 * 1024);
+    }
+
+  private:
+    struct Slot
+    {
+        std::atomic<uint64_t> keyXorCount;
+        std::atomic<uint64_t> count;
+    };
+
+    struct alignas(64) Bucket
+    {
+        Slot slots[PERFT_BUCKET_SIZE];
+    };
+
+    // the same position at another depth is another entry, the depth is mixed into the key
+    static inline Key DepthKey(Key key, unsigned int depth)
+    {
+        return key ^ (depth * 0x9E3779B97F4A7C15ULL);
+    }
+
+    inline Bucket* GetBucket(Key key) const
+    {
+        return &buckets[(unsigned long long)(((unsigned __int128)key * numBuckets) >> 64)];
+    }
+
+    Bucket* buckets;
+    unsigned long long numBuckets;
+    LargeAllocation memory; // backing memory of buckets
+};
+
+/**
+ * @brief Counts the leaf nodes of the legal move tree of a position
+ *
+ * @param board the position, it is restored before returning
+ * @param depth the depth of the tree
+ * @param table if not nullptr, subtrees are looked up there first and stored there after
+ * @return unsigned long long
+ */
+extern unsigned long long perft(Board& board, unsigned int depth, PerftTable* table = nullptr);
 
-extern unsigned long long perft(Board &board, unsigned int depth);
+/**
+ * @brief Counts the leaf nodes of the legal move tree of a position on several threads. The subtrees two plies below
+ * the root (one ply for depth 2) are handed out to the threads one at a time, so a thread that finishes early takes
+ * the next pending subtree instead of waiting for the others
+ *
+ * @param board the position
+ * @param depth the depth of the tree
+ * @param threads number of threads, at least 1
+ * @param table if not nullptr, shared by all threads to reuse transposed subtrees
+ * @param divide if not nullptr, receives every root move with its number of leaf nodes, in move generation order
+ * @return unsigned long long the total number of leaf nodes
+ */
+unsigned long long PerftDivide(const Board& board, unsigned int depth, unsigned int threads, PerftTable* table,
+                               std::vector<std::pair<Move, unsigned long long>>* divide = nullptr);
 
 #endif // PERFT_H
\ No newline at end of file
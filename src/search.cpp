@@ -3,8 +3,8 @@
 #include <climits>
 #include <cmath>
 #include <cstring>
-#include <format>
 #include <iostream>
+#include <unordered_map>
 
 #include "search.h"
 
@@ -29,8 +29,15 @@ constexpr float aspirationMultiplier = 1.5f;
 #define NULL_DEPTH 3
 #define IIR_DEPTH 3 // internal iterative reduction depth
 #define FUTILITY_MARGIN(DEPTH) (80 + 120 * (DEPTH))
+#define RFP_DEPTH 8 // maximum depth for reverse futility pruning
+#define RFP_MARGIN(DEPTH) (120 * (DEPTH))
 #define DELTA 200
 
+// Lazy SMP depth skipping for helper threads, helper i skips depth d if ((d + phase) / size) is odd
+constexpr int helperSkipCount = 20;
+constexpr int helperSkipSize[helperSkipCount] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+constexpr int helperSkipPhase[helperSkipCount] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
 constexpr auto lmrTable = [] {
     std::array<std::array<int, 256>, MAX_DEPTH> table{};
     for (int d = 0; d < MAX_DEPTH; d++)
@@ -95,16 +102,15 @@ std::string GetMoveListString(PVLine* l)
     return moves;
 }
 
-Searcher::Searcher()
-    : ttable(64 * 1024), isRunning(false), isSearching(false), isQuit(false),
-      thread(std::thread([this] { WorkerLoop(); }))
+SearchWorker::SearchWorker(Searcher& searcher, unsigned int id)
+    : searcher(searcher), constraints(searcher.constraints), ttable(searcher.ttable), isRunning(searcher.isRunning),
+      id(id), info{}, accumulators(searcher.network.get()), evalCache(searcher.evalCacheSize), completedDepth(0),
+      nodesSearched(0), isSearching(false), isQuit(false), thread(std::thread([this] { WorkerLoop(); }))
 {
 }
 
-Searcher::~Searcher()
+SearchWorker::~SearchWorker()
 {
-    Stop();
-
     {
         std::lock_guard lock(mtx);
         isQuit = true;
@@ -115,7 +121,7 @@ Searcher::~Searcher()
         thread.join();
 }
 
-void Searcher::Makemove(Move m, BoardState& state, int ply)
+void SearchWorker::Makemove(Move m, BoardState& state, int ply)
 {
     accumulators.SetCurrent(ply + 1);
     accumulators.Current().isWhiteComputed = false;
@@ -124,13 +130,39 @@ void Searcher::Makemove(Move m, BoardState& state, int ply)
     board.makeMove(m, &state, accumulators.Current().dirtyMove);
 }
 
-void Searcher::Undomove(int ply)
+void SearchWorker::Undomove(int ply)
 {
     accumulators.SetCurrent(ply);
     board.undoMove();
 }
 
-void Searcher::MakeNullmove(BoardState& state, int ply)
+Score SearchWorker::Evaluate(Score alpha, Score beta, bool& lazy)
+{
+    lazy = false;
+
+    // a hit skips the accumulators too, they are caught up lazily by the next evaluation that needs them
+    Score eval;
+    if (evalCache.Probe(board.getHash(), eval))
+        return eval;
+
+    // the psqt-only evaluation brings the accumulators up to date, the full one below only adds the forward pass
+    if (searcher.lazyEvalMargin)
+    {
+        eval = Eval<FAST>(board, accumulators);
+        if (eval - searcher.lazyEvalMargin >= beta || eval + searcher.lazyEvalMargin <= alpha)
+        {
+            UPDATE_INFO_LAZYEVAL(info);
+            lazy = true;
+            return eval;
+        }
+    }
+
+    eval = Eval<FULL>(board, accumulators);
+    evalCache.Store(board.getHash(), eval);
+    return eval;
+}
+
+void SearchWorker::MakeNullmove(BoardState& state, int ply)
 {
     accumulators.SetCurrent(ply + 1);
     accumulators.Current().isWhiteComputed = false;
@@ -139,52 +171,51 @@ void Searcher::MakeNullmove(BoardState& state, int ply)
     board.makeNullMove(&state);
 }
 
-void Searcher::UndoNullmove(int ply)
+void SearchWorker::UndoNullmove(int ply)
 {
     accumulators.SetCurrent(ply);
     board.undoNullMove();
 }
 
-Score Searcher::QSearch(int ply, Score alpha, Score beta, SearchNode* node)
+Score SearchWorker::QSearch(int ply, Score alpha, Score beta, SearchNode* node)
 {
     PROFILE_FUNC();
     UPDATE_INFO_QNODES(info);
+    nodesSearched.store(info.numNodes + info.numQNodes, std::memory_order_relaxed);
 
     // 50 move and 3 fold draws are checked before QSearch is called
 
-    TranspositionEntry* entry = ttable.GetEntry(board.getHash());
+    TranspositionEntry entry;
+    const bool ttHit = ttable.Probe(board.getHash(), entry);
     Move bestEntryMove = 0;
-    if (entry)
+    if (ttHit)
     {
         UPDATE_INFO_TTQHIT(info);
 
-        Score corrected = ttToMate(entry->score, ply);
-        if (entry->getNodeBound() == NodeBound::Exact ||
-            (entry->getNodeBound() == NodeBound::Upper && corrected <= alpha) ||
-            (entry->getNodeBound() == NodeBound::Lower && corrected >= beta))
+        Score corrected = ttToMate(entry.score, ply);
+        if (entry.getNodeBound() == NodeBound::Exact ||
+            (entry.getNodeBound() == NodeBound::Upper && corrected <= alpha) ||
+            (entry.getNodeBound() == NodeBound::Lower && corrected >= beta))
         {
             UPDATE_INFO_TTQCUT(info);
-            entry->setAge(ttable.GetAge()); // reset the age for this node
             return corrected;
         }
 
-        bestEntryMove = entry->move;
+        bestEntryMove = entry.move;
     }
 
     Score originalAlpha = alpha;
     Score pat = 0;
+    Score staticEval = EVAL_NONE;
 
-    // Generate moves
-
-    MoveList moves;
-    if (!board.getNumChecks()) // If not in check, generate captures
+    const bool inCheck = board.getNumChecks() > 0;
+    if (!inCheck)
     {
-        board.generateMoves<CAPTURE>(&moves);
-        pat = Eval<FULL>(board, accumulators);
-        if (!moves.GetSize())
-        {
-            return pat;
-        }
+        // reuse the stored eval on a hit so the accumulators don't have to be updated
+        bool lazy = false;
+        pat = ttHit && entry.eval != EVAL_NONE ? entry.eval : Evaluate(alpha, beta, lazy);
+        if (!lazy) // a lazy stand pat is only good enough for this window, it is kept out of the TT
+            staticEval = pat;
 
         if (pat >= beta)
             return pat;
@@ -192,27 +223,25 @@ Score Searcher::QSearch(int ply, Score alpha, Score beta, SearchNode* node)
         if (alpha < pat)
             alpha = pat;
     }
-    else // if in check, generate evasions
-    {
-        board.generateMoves<ALL_MOVES>(&moves);
-        if (!moves.GetSize()) // if no moves, checkmate
-        {
-            return -MATE + ply;
-        }
+    else
         pat = -MATE; // in check
-    }
 
-    MoveSorter sorter(board, &moves, bestEntryMove);
+    MovePicker picker(board, history, bestEntryMove, QUIESCENCE);
 
     Move bestM = 0;
     BoardState state;
+    int moveCount = 0;
 
-    while (sorter.size)
+    for (Move m = picker.Next(); m.getMove(); m = picker.Next())
     {
-        Move m = sorter.Next();
+        moveCount++;
+
+        // skip captures that lose material
+        if (!inCheck && !board.see(m, 0))
+            continue;
 
         // Delta pruning
-        if (!board.getNumChecks() && !m.isType<PROMOTION>())
+        if (!inCheck && !m.isType<PROMOTION>())
         {
             Piece capturedPiece = board.getSQ(m.to());
             if (capturedPiece == EMPTY) // en-passant
@@ -233,7 +262,7 @@ Score Searcher::QSearch(int ply, Score alpha, Score beta, SearchNode* node)
 
             if (score >= beta)
             {
-                ttable.SetEntry(board.getHash(), mateToTT(score, ply), 0, NodeBound::Lower, m);
+                ttable.SetEntry(board.getHash(), mateToTT(score, ply), staticEval, 0, NodeBound::Lower, m);
                 UPDATE_INFO_QBETACUT(info);
                 return score;
             }
@@ -243,14 +272,18 @@ Score Searcher::QSearch(int ply, Score alpha, Score beta, SearchNode* node)
             }
         }
     }
+
+    if (inCheck && moveCount == 0) // no evasions, checkmate
+        return -MATE + ply;
+
     NodeBound bound = (pat >= beta) ? NodeBound::Lower : (pat > originalAlpha) ? NodeBound::Exact : NodeBound::Upper;
-    ttable.SetEntry(board.getHash(), mateToTT(pat, ply), 0, bound, bestM);
+    ttable.SetEntry(board.getHash(), mateToTT(pat, ply), staticEval, 0, bound, bestM);
 
     return pat;
 }
 
 template <NodeType nodeT>
-Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode* node, const bool nullMoveAllowed)
+Score SearchWorker::Search(int depth, int ply, Score alpha, Score beta, SearchNode* node, const bool nullMoveAllowed)
 {
     constexpr bool isPVNode = nodeT == PVNode || nodeT == RootNode;
     constexpr bool isRootNode = nodeT == RootNode;
@@ -258,16 +291,24 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
     if (!isRunning.load(std::memory_order::memory_order_relaxed))
         return 0;
 
-    if (getTime() - info.startTime > constraints.movetime)
+    // only the main thread checks the limits, the helpers are stopped through isRunning
+    if (IsMainThread())
     {
-        isRunning = false;
-        return 0;
-    }
+        if (--nodesUntilTimeCheck <= 0)
+        {
+            nodesUntilTimeCheck = TIME_CHECK_INTERVAL;
+            if (!searcher.isPondering && searcher.timeman.HardLimitReached())
+            {
+                isRunning = false;
+                return 0;
+            }
 
-    if (info.numNodes + info.numQNodes > constraints.maxNodes)
-    {
-        isRunning = false;
-        return 0;
+            if (constraints.maxNodes != UINT_MAX && searcher.NodesSearched() > constraints.maxNodes)
+            {
+                isRunning = false;
+                return 0;
+            }
+        }
     }
 
     if (!isRootNode && board.getState()->repetition == 3)
@@ -282,12 +323,14 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
     }
 
     UPDATE_INFO_NODES(info);
+    nodesSearched.store(info.numNodes + info.numQNodes, std::memory_order_relaxed);
     if (isPVNode && info.seldepth < ply)
     {
         info.seldepth = ply;
     }
 
-    TranspositionEntry* entry = nullptr;
+    TranspositionEntry entry;
+    bool ttHit = false;
     Score ttOrStaticScore = 0; // set below: from TT score if available, otherwise from staticEval
 
     Move bestEntryMove = 0;
@@ -298,29 +341,28 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
     }
     else
     {
-        entry = ttable.GetEntry(board.getHash());
+        ttHit = ttable.Probe(board.getHash(), entry);
 
-        if (entry)
+        if (ttHit)
         {
-            ttOrStaticScore = ttToMate(entry->score, ply);
-            entry->setAge(ttable.GetAge()); // reset the age for this node
+            ttOrStaticScore = ttToMate(entry.score, ply);
 
             UPDATE_INFO_TTHIT(info);
             if constexpr (!isPVNode)
             {
-                if (entry->depth >= depth)
+                if (entry.depth >= depth)
                 {
-                    if ((entry->getNodeBound() == NodeBound::Exact ||
-                         (entry->getNodeBound() == NodeBound::Upper && ttOrStaticScore <= alpha) ||
-                         (entry->getNodeBound() == NodeBound::Lower && ttOrStaticScore >= beta)))
+                    if ((entry.getNodeBound() == NodeBound::Exact ||
+                         (entry.getNodeBound() == NodeBound::Upper && ttOrStaticScore <= alpha) ||
+                         (entry.getNodeBound() == NodeBound::Lower && ttOrStaticScore >= beta)))
                     {
                         UPDATE_INFO_TTCUT(info);
                         return ttOrStaticScore;
                     }
 
-                    if (entry->getNodeBound() == NodeBound::Lower)
+                    if (entry.getNodeBound() == NodeBound::Lower)
                         alpha = std::max(alpha, ttOrStaticScore);
-                    else if (entry->getNodeBound() == NodeBound::Upper)
+                    else if (entry.getNodeBound() == NodeBound::Upper)
                         beta = std::min(beta, ttOrStaticScore);
 
                     if (alpha >= beta)
@@ -331,7 +373,7 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
                 }
             }
 
-            bestEntryMove = entry->move;
+            bestEntryMove = entry.move;
         }
         else if constexpr (!isPVNode)
         {
@@ -342,10 +384,25 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
     }
 
     Score staticEval;
+    Score rawEval = EVAL_NONE; // eval stored in the TT, none if in check
     bool inCheck = board.getNumChecks() > 0;
 
     if (!inCheck)
-        staticEval = Eval<FULL>(board, accumulators);
+    {
+        // reuse the stored eval on a hit so the accumulators don't have to be updated
+        if (ttHit && entry.eval != EVAL_NONE)
+            rawEval = entry.eval;
+        else
+        {
+            // only reverse futility candidates can use a lazy eval, if it is far enough above beta to prune the node
+            const Score lazyBeta = !isPVNode && depth <= RFP_DEPTH ? beta + RFP_MARGIN(depth) : INF;
+            bool lazy;
+            rawEval = Evaluate(-INF, lazyBeta, lazy);
+            if (lazy)
+                return rawEval;
+        }
+        staticEval = rawEval;
+    }
     else if (node->prev && node->prev->prev)
         staticEval = node->prev->prev->staticEval;
     else
@@ -353,26 +410,13 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
 
     node->staticEval = staticEval;
 
-    if (!entry)
+    if (!ttHit)
         ttOrStaticScore = node->staticEval;
 
-    MoveList moves;
-    board.generateMoves<ALL_MOVES>(&moves);
-
-    if (moves.GetSize() == 0)
-    {
-        Score mateScore = 0; // stalemate
-        if (inCheck)         // if in check, then checkmate
-            mateScore = -MATE + ply;
-
-        ttable.SetEntry(board.getHash(), mateToTT(mateScore, ply), depth, NodeBound::Exact, 0);
-        return mateScore;
-    }
-
     // reverse futility pruning
-    if (!isPVNode && !inCheck && depth <= 8)
+    if (!isPVNode && !inCheck && depth <= RFP_DEPTH)
     {
-        Score margin = 120 * depth;
+        Score margin = RFP_MARGIN(depth);
 
         if (staticEval - margin >= beta)
         {
@@ -419,7 +463,8 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
         }
     }
 
-    MoveSorter sorter(board, &moves, bestEntryMove);
+    MovePicker picker(board, history, bestEntryMove, NORMAL);
+    MoveList triedMoves; // moves returned by the picker so far, they get a history penalty on a beta cutoff
 
     Score bestS = -INF;
     Move bestM = 0;
@@ -428,9 +473,10 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
     Move firstMove = 0;
     int lmpCount = 0;
     const int lmpThreshold = 3 + 2 * depth * depth;
-    for (int i = 0; sorter.size != 0; i++)
+    int i = 0; // number of moves returned by the picker before this one
+    for (Move move = picker.Next(); move.getMove(); move = picker.Next(), i++)
     {
-        Move move = sorter.Next();
+        triedMoves.addMove(move);
 
         if (!isPVNode && !inCheck && move.isType<QUIET>())
         {
@@ -453,6 +499,8 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
                 continue;
         }
 
+        const unsigned long long nodesBefore = info.numNodes + info.numQNodes;
+
         SearchNode child(node);
         Makemove(move, state, ply);
         ttable.Prefetch(board.getHash());
@@ -519,11 +567,12 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
         // update root move score if we are root node
         if constexpr (isRootNode)
         {
-            for (int i = 0; i < info.rootMoves.numRoots; i++)
+            for (int r = 0; r < info.rootMoves.numRoots; r++)
             {
-                if (info.rootMoves[i].move == move)
+                if (info.rootMoves[r].move == move)
                 {
-                    info.rootMoves[i].score = score;
+                    info.rootMoves[r].score = score;
+                    info.rootMoves[r].nodes += info.numNodes + info.numQNodes - nodesBefore;
                     break;
                 }
             }
@@ -539,39 +588,39 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
                 PieceType victimType = getType(board.getSQ(move.to()));
                 if (move.to() == board.getEnPassantSqr())
                     victimType = PAWN;
-                addCaptureBonus(victimType, move, depth); // add move history bonus
+                history.addCaptureBonus(victimType, move, depth); // add move history bonus
             }
             else
             {
                 if (board.getState()->move.getMove() != 0) // don't add for null moves
-                    counterMove[board.getState()->move.from()][board.getState()->move.to()] = move;
+                    history.counterMove[board.getState()->move.from()][board.getState()->move.to()] = move;
 
-                addKillerMove(board.getPly(), move);
-                addHistoryBonus(board.whiteToMove, move, depth); // add move history bonus
-                updateContinuationHistory(board, move, depth, false);
+                history.addKillerMove(board.getPly(), move);
+                history.addHistoryBonus(board.whiteToMove, move, depth); // add move history bonus
+                history.updateContinuationHistory(board, move, depth, false);
             }
 
-            for (unsigned int p = moves.GetSize() - i; p < moves.GetSize(); p++)
+            for (unsigned int p = 0; p < triedMoves.GetSize(); p++)
             {
-                Move penaltyMove = sorter.moveVals[p].m;
+                Move penaltyMove = triedMoves[p];
                 if (penaltyMove == move)
                     continue;
 
                 if (penaltyMove.isType<QUIET>())
                 {
-                    addHistoryPenalty(board.whiteToMove, penaltyMove, depth);
-                    updateContinuationHistory(board, penaltyMove, depth, true);
+                    history.addHistoryPenalty(board.whiteToMove, penaltyMove, depth);
+                    history.updateContinuationHistory(board, penaltyMove, depth, true);
                 }
                 else if (penaltyMove.isType<CAPTURE>())
                 {
                     PieceType victimType = getType(board.getSQ(penaltyMove.to()));
                     if (penaltyMove.to() == board.getEnPassantSqr())
                         victimType = PAWN;
-                    addCapturePenalty(victimType, penaltyMove, depth);
+                    history.addCapturePenalty(victimType, penaltyMove, depth);
                 }
             }
 
-            ttable.SetEntry(board.getHash(), mateToTT(score, ply), depth, NodeBound::Lower, move);
+            ttable.SetEntry(board.getHash(), mateToTT(score, ply), rawEval, depth, NodeBound::Lower, move);
             UPDATE_INFO_BETACUT(info);
             UPDATE_INFO_BETACUTMOVE(info, i);
             return score;
@@ -594,23 +643,36 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
             if constexpr (isRootNode)
             {
                 info.pv = node->pvLine;
-                info.bestmove = {bestM, bestS};
+                info.bestmove = {bestM, bestS, 0};
 
-                uint64_t time = getTime() - info.startTime;
-                uint64_t nodes = info.numNodes + info.numQNodes;
-                uint64_t nps = nodes * 1000 / std::max(time, 1ull);
+                if (IsMainThread())
+                {
+                    uint64_t time = getTime() - info.startTime;
+                    uint64_t nodes = searcher.NodesSearched();
+                    uint64_t nps = nodes * 1000 / std::max<uint64_t>(time, 1);
 
-                std::cout << "info depth " << depth << " best " << bestM.toString() << " score cp " << score << " time "
-                          << time << " nodes " << info.numNodes + info.numQNodes << " nps " << nps << " pv "
-                          << GetMoveListString(&info.pv) << "\n";
+                    std::cout << "info depth " << depth << " best " << bestM.toString() << " score cp " << score
+                              << " time " << time << " nodes " << nodes << " nps " << nps << " pv "
+                              << GetMoveListString(&info.pv) << "\n";
+                }
             }
         }
     }
 
+    if (i == 0) // no legal moves
+    {
+        Score mateScore = 0; // stalemate
+        if (inCheck)         // if in check, then checkmate
+            mateScore = -MATE + ply;
+
+        ttable.SetEntry(board.getHash(), mateToTT(mateScore, ply), rawEval, depth, NodeBound::Exact, 0);
+        return mateScore;
+    }
+
     if (firstMove == bestM)
         UPDATE_INFO_PVHIT(info);
 
-    if (moves.GetSize() >= 2)
+    if (i >= 2)
         UPDATE_INFO_ORDERHIT(info);
 
     if (bestM.getMove() == 0) // if we didn't search a move (futility pruned all moves)
@@ -618,29 +680,38 @@ Score Searcher::Search(int depth, int ply, Score alpha, Score beta, SearchNode*
 
     if (isRunning.load(std::memory_order::memory_order_relaxed)) // don't store in transposition table if we cutoff
                                                                  // early (Time cutoff, node cutoff, etc.)
-        ttable.SetEntry(board.getHash(), mateToTT(bestS, ply), depth, nodeBound, bestM);
+        ttable.SetEntry(board.getHash(), mateToTT(bestS, ply), rawEval, depth, nodeBound, bestM);
 
     return bestS;
 }
 
-void Searcher::IterativeDeepening(Board& board)
+void SearchWorker::IterativeDeepening(Board& board)
 {
     SearchNode origin(nullptr);
 
     accumulators.SetCurrent(0);
     auto& originAcc = accumulators.Current();
 
-    board.ResetWhiteAccumulator(originAcc.whiteAcc);
-    board.ResetBlackAccumulator(originAcc.blackAcc);
+    board.ResetWhiteAccumulator(*searcher.network, originAcc.whiteAcc);
+    board.ResetBlackAccumulator(*searcher.network, originAcc.blackAcc);
     originAcc.isBlackComputed = originAcc.isWhiteComputed = true;
 
     RootMove prevBestMove;
+    PVLine prevPV;
     info.bestmove.score = 0;
     prevBestMove.score = 0;
     prevBestMove.move = 0;
 
     for (unsigned int d = 1; d <= constraints.maxDepth; d++)
     {
+        // helpers skip some depths so the threads spread out over different iterations
+        if (!IsMainThread() && d > 1)
+        {
+            const int i = (id - 1) % helperSkipCount;
+            if (((d + helperSkipPhase[i]) / helperSkipSize[i]) % 2)
+                continue;
+        }
+
         info.seldepth = 0;
 
         Score delta = aspirationStartingDelta;
@@ -674,97 +745,126 @@ void Searcher::IterativeDeepening(Board& board)
             }
         }
 
-        uint64_t time = getTime() - info.startTime;
-        uint64_t nodes = info.numNodes + info.numQNodes;
-        uint64_t nps = nodes * 1000 / std::max(time, 1ull);
-
-        std::cout << "info depth " << d << " seldepth " << info.seldepth + 1 << " currmov "
-                  << info.bestmove.move.toString() << " score cp " << info.bestmove.score << " nodes " << nodes
-                  << " time " << time << " nps " << nps << " hashfull " << (int)(ttable.GetFull() * 1000) << " pv "
-                  << GetMoveListString(&info.pv) << "\n";
+        if (IsMainThread())
+        {
+            uint64_t time = getTime() - info.startTime;
+            uint64_t nodes = searcher.NodesSearched();
+            uint64_t nps = nodes * 1000 / std::max<uint64_t>(time, 1);
+
+            std::cout << "info depth " << d << " seldepth " << info.seldepth + 1 << " currmov "
+                      << info.bestmove.move.toString() << " score cp " << info.bestmove.score << " nodes " << nodes
+                      << " time " << time << " nps " << nps << " hashfull " << ttable.Hashfull()
+                      << " pv " << GetMoveListString(&info.pv) << "\n";
+        }
 
         if (!isRunning.load(std::memory_order::memory_order_relaxed))
         {
             info.bestmove = prevBestMove;
+            info.pv = prevPV;
             break;
         }
 
         prevBestMove = info.bestmove;
-    }
-}
+        prevPV = info.pv;
+        completedDepth = d;
 
-void Searcher::ComputeMovetime()
-{
-    if (constraints.remainingTime > 0)
-    {
-        float maxTime = static_cast<float>(constraints.remainingTime) / 25.0f;
-
-        // adjust movetime based on how many roots moves exist
-        if (info.rootMoves.numRoots > 30)
-        {
-            maxTime *= 1.5;
-        }
-        else if (info.rootMoves.numRoots < 10)
+        if (IsMainThread())
         {
-            maxTime *= 0.75;
-        }
-        else
-        {
-            maxTime *= 0.9;
+            unsigned long long bestMoveNodes = 0;
+            for (int r = 0; r < info.rootMoves.numRoots; r++)
+            {
+                if (info.rootMoves[r].move == info.bestmove.move)
+                    bestMoveNodes = info.rootMoves[r].nodes;
+            }
+
+            const double nodeFraction = (double)bestMoveNodes / std::max(1ULL, info.numNodes + info.numQNodes);
+            if (searcher.timeman.ShouldStop(info.bestmove.move, nodeFraction))
+            {
+                // keep searching while pondering, the search stops as soon as ponderhit is received
+                if (searcher.isPondering)
+                    searcher.stopOnPonderhit = true;
+                else
+                {
+                    isRunning = false;
+                    break;
+                }
+            }
         }
-        constraints.movetime = (unsigned int)std::min(maxTime, (float)constraints.remainingTime *
-                                                                   0.2f); // use at most 20% of remaining time
-        if (constraints.movetime == 0)
-            constraints.movetime = 1;
-    }
-    else
-    {
-        constraints.movetime = constraints.movetime == 0 ? UINT_MAX : constraints.movetime;
     }
 }
 
-void Searcher::DoSearch()
+void SearchWorker::DoSearch()
 {
-    info = {};
-    std::memset(killerMoves, 0, sizeof(killerMoves));
-
-    info.startTime = getTime();
-
-    info.rootMoves.Clear();
-    info.bestmove = RootMove{0, 0};
-
-    constraints.maxDepth = constraints.maxDepth == 0 ? MAX_DEPTH : constraints.maxDepth;
-    constraints.maxNodes = constraints.maxNodes == 0 ? UINT_MAX : constraints.maxNodes;
-    ComputeMovetime();
+    // info and completedDepth were reset by the Searcher before the worker was woken up
 
     MoveList mlist;
     board.generateMoves<ALL_MOVES>(&mlist);
 
     for (Move* i = mlist.moves; i < mlist.end; i++)
     {
-        info.rootMoves.Add(RootMove{*i, 0});
+        info.rootMoves.Add(RootMove{*i, 0, 0});
     }
 
-    ttable.IncrementAge();
     IterativeDeepening(board);
 
-    std::cout << "bestmove " << info.bestmove.move.toString() << std::endl;
+    info.evalCacheHits = evalCache.GetHits();
+    info.evalCacheMisses = evalCache.GetMisses();
+
+    if (!IsMainThread())
+        return;
+
+    // bestmove can't be sent while pondering, wait for ponderhit or stop
+    while (searcher.isPondering && isRunning)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // the main thread is done (time ran out, depth reached or stop was sent), stop the helpers and collect their results
+    isRunning = false;
+    for (size_t i = 1; i < searcher.workers.size(); i++)
+        searcher.workers[i]->WaitForSearchFinished();
+
+    SearchWorker* best = searcher.GetBestWorker();
+
+    std::cout << "bestmove " << best->info.bestmove.move.toString();
+    Move ponderMove = best->GetPonderMove();
+    if (ponderMove.getMove())
+        std::cout << " ponder " << ponderMove.toString();
+    std::cout << std::endl;
     PrintDebugInfo(info);
-    Stop();
 }
 
-void Searcher::WorkerLoop()
+Move SearchWorker::GetPonderMove()
+{
+    const Move bestMove = info.bestmove.move;
+    if (!bestMove.getMove())
+        return 0;
+
+    if (info.pv.len >= 2 && info.pv.moves[0] == bestMove)
+        return info.pv.moves[1];
+
+    // the pv was cut short (e.g. by a TT cutoff), use the TT move of the position after the best move
+    BoardState state;
+    DirtyMove dirtyMove;
+    board.makeMove(bestMove, &state, dirtyMove);
+
+    Move ponderMove = 0;
+    TranspositionEntry entry;
+    if (ttable.Probe(board.getHash(), entry) && board.isPseudoLegal(entry.move) && board.isLegal(entry.move))
+        ponderMove = entry.move;
+
+    board.undoMove();
+    return ponderMove;
+}
+
+void SearchWorker::WorkerLoop()
 {
     while (true)
     {
         {
             std::unique_lock lock(mtx);
-            cv.wait(lock, [&] { return isRunning == true || isQuit == true; });
-        }
+            cv.wait(lock, [&] { return isSearching || isQuit; });
 
-        if (isQuit)
-        {
-            break;
+            if (isQuit)
+                break;
         }
 
         DoSearch();
@@ -777,22 +877,204 @@ void Searcher::WorkerLoop()
     }
 }
 
-void Searcher::StartSearch(const Board& board, const SearchConstraints& constraints)
+void SearchWorker::StartSearching()
 {
-    Stop();
+    {
+        std::lock_guard lock(mtx);
+        isSearching = true;
+    }
+    cv.notify_all();
+}
 
+void SearchWorker::WaitForSearchFinished()
+{
     std::unique_lock lock(mtx);
     cv.wait(lock, [this] { return !isSearching; });
+}
+
+Searcher::Searcher(std::shared_ptr<const NNUE> network)
+    : network(std::move(network)), evalCacheSize(DEFAULT_EVAL_CACHE_KB), lazyEvalMargin(DEFAULT_LAZY_EVAL_MARGIN),
+      ttable(64), isRunning(false), isPondering(false), stopOnPonderhit(false)
+{
+    SetThreads(1);
+}
+
+Searcher::~Searcher()
+{
+    Stop();
+    WaitForSearchFinished();
+}
+
+void Searcher::SetThreads(unsigned int numThreads)
+{
+    Stop();
+    WaitForSearchFinished();
+
+    numThreads = std::max(numThreads, 1u);
+
+    workers.clear();
+    for (unsigned int i = 0; i < numThreads; i++)
+        workers.emplace_back(std::make_unique<SearchWorker>(*this, i));
+}
+
+void Searcher::SetEvalCacheSize(unsigned int kilobytes)
+{
+    Stop();
+    WaitForSearchFinished();
+
+    evalCacheSize = kilobytes;
+    for (auto& worker : workers)
+        worker->evalCache.Resize(kilobytes);
+}
+
+void Searcher::SetLazyEvalMargin(Score margin)
+{
+    Stop();
+    WaitForSearchFinished();
+
+    lazyEvalMargin = margin;
+}
+
+void Searcher::SetNetwork(std::shared_ptr<const NNUE> network)
+{
+    Stop();
+    WaitForSearchFinished();
+
+    this->network = std::move(network);
+
+    // the workers' accumulators and refresh caches are tied to the old network
+    SetThreads((unsigned int)workers.size());
+
+    // every entry stores the static eval of the old network
+    ttable.Clear((unsigned int)workers.size());
+}
+
+void Searcher::SetHashSize(unsigned long long megabytes)
+{
+    Stop();
+    WaitForSearchFinished();
+
+    ttable.Resize(std::max(megabytes, 1ULL), (unsigned int)workers.size());
+}
+
+unsigned long long Searcher::NodesSearched() const
+{
+    unsigned long long nodes = 0;
+    for (const auto& worker : workers)
+        nodes += worker->nodesSearched.load(std::memory_order_relaxed);
+
+    return nodes;
+}
+
+SearchWorker* Searcher::GetBestWorker()
+{
+    SearchWorker* best = workers[0].get();
+    if (workers.size() == 1)
+        return best;
+
+    // every thread votes for its best move, weighted by the depth it finished and by how much better its score is
+    // than the worst score found by any thread
+    Score minScore = INF;
+    for (const auto& worker : workers)
+    {
+        if (worker->completedDepth)
+            minScore = std::min(minScore, worker->info.bestmove.score);
+    }
+
+    std::unordered_map<uint16_t, long long> votes;
+    for (const auto& worker : workers)
+    {
+        if (worker->completedDepth)
+            votes[worker->info.bestmove.move.getMove()] +=
+                (worker->info.bestmove.score - minScore + 14) * (long long)worker->completedDepth;
+    }
+
+    for (const auto& worker : workers)
+    {
+        if (!worker->completedDepth || !worker->info.bestmove.move.getMove())
+            continue;
+
+        const Score score = worker->info.bestmove.score;
+        const Score bestScore = best->info.bestmove.score;
+
+        // a proven mate always wins the vote, otherwise the most voted move is played
+        if (isWin(bestScore))
+        {
+            if (score > bestScore)
+                best = worker.get();
+        }
+        else if (isWin(score) || votes[worker->info.bestmove.move.getMove()] >
+                                     votes[best->info.bestmove.move.getMove()])
+        {
+            best = worker.get();
+        }
+    }
+
+    return best;
+}
+
+void Searcher::WaitForSearchFinished()
+{
+    for (auto& worker : workers)
+        worker->WaitForSearchFinished();
+}
+
+void Searcher::StartSearch(const Board& board, const SearchConstraints& constraints)
+{
+    Stop();
+    WaitForSearchFinished();
 
-    this->board = board;
     this->constraints = constraints;
+    this->constraints.maxDepth = constraints.maxDepth == 0 ? MAX_DEPTH : constraints.maxDepth;
+    this->constraints.maxNodes = constraints.maxNodes == 0 ? UINT_MAX : constraints.maxNodes;
+
+    Board root = board;
+    MoveList mlist;
+    root.generateMoves<ALL_MOVES>(&mlist);
+
+    // the workers share the root state, so whatever it caches has to be filled in before they start
+    root.getAttacked(WHITE);
+    root.getAttacked(BLACK);
+    root.getCheckInfo(); // not filled in by the move generator when in double check
+    timeman.Start(constraints.remainingTime, constraints.increment, constraints.movesToGo, constraints.movetime,
+                  mlist.GetSize());
+
+    ttable.IncrementAge();
+
+    isPondering = constraints.ponder;
+    stopOnPonderhit = false;
     isRunning = true;
-    isSearching = true;
 
-    cv.notify_all();
+    for (auto& worker : workers)
+    {
+        worker->board = board;
+        worker->info = {};
+        worker->nodesSearched = 0;
+        worker->evalCache.ResetStats();
+        worker->info.startTime = timeman.GetStartTime();
+        worker->completedDepth = 0;
+        worker->nodesUntilTimeCheck = TIME_CHECK_INTERVAL;
+        worker->history.ClearKillers();
+    }
+
+    for (auto& worker : workers)
+        worker->StartSearching();
 }
 
 void Searcher::Stop()
 {
+    isPondering = false;
     isRunning = false;
+}
+
+void Searcher::PonderHit()
+{
+    if (stopOnPonderhit)
+    {
+        Stop();
+        return;
+    }
+
+    timeman.RestartClock();
+    isPondering = false;
 }
\ No newline at end of file
@@ -3,17 +3,27 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
+#include "MoveSort.h"
 #include "SearchNode.h"
 #include "board.h"
+#include "evalCache.h"
 #include "move.h"
 #include "movegen.h"
 #include "nnue/accumulatorList.h"
+#include "nnue/nnue.h"
 #include "transposition.h"
 #include "types.h"
 #include "searchInfo.h"
+#include "timeman.h"
+
+// psqt-only evaluations further than this outside the window are used as they are, 0 always runs the full network.
+// Off by default until a margin has been tuned for the current network
+#define DEFAULT_LAZY_EVAL_MARGIN 0
 
 enum NodeType
 {
@@ -37,13 +47,32 @@ struct SearchConstraints
 
     // the amount of time left for the current side (milliseconds)
     unsigned int remainingTime;
+
+    // increment per move for the current side (milliseconds)
+    unsigned int increment;
+
+    // moves until the next time control, 0 if the remaining time has to last for the rest of the game
+    unsigned int movesToGo;
+
+    // search the position after the expected reply of the opponent until ponderhit or stop, the time limits only
+    // start counting on ponderhit
+    bool ponder;
 };
 
-class Searcher
+class Searcher;
+
+/**
+ * @brief A single search thread. Every worker owns its own board, accumulator stack and search info, and shares the
+ * transposition table, constraints and stop flag of the Searcher that created it (Lazy SMP)
+ */
+class SearchWorker
 {
   public:
-    Searcher();
-    ~Searcher();
+    SearchWorker(Searcher& searcher, unsigned int id);
+    ~SearchWorker();
+
+    SearchWorker(const SearchWorker&) = delete;
+    SearchWorker& operator=(const SearchWorker&) = delete;
 
     void Makemove(Move m, BoardState& state, int ply);
     void Undomove(int ply);
@@ -52,47 +81,164 @@ class Searcher
     void UndoNullmove(int ply);
 
     /**
-     * @brief Starts a search for the best move and evaluation for a given position
-     *
-     * @param board the current position
-     * @param constraints search constraints
+     * @brief Wakes the worker up so it starts searching the position that was set by the Searcher
      */
-    void StartSearch(const Board& board, const SearchConstraints& constraints);
-
-    void Stop();
+    void StartSearching();
 
-    inline const SearchInfo& GetSearchInfo()
-    {
-        return info;
-    }
+    /**
+     * @brief Blocks until the worker has finished its current search
+     */
+    void WaitForSearchFinished();
 
-    void ClearTT()
+    inline bool IsMainThread() const
     {
-        ttable.Clear();
+        return id == 0;
     }
 
   private:
-    SearchConstraints constraints;
+    friend class Searcher;
+
+    Searcher& searcher;
+    const SearchConstraints& constraints;
+    TranspositionTable& ttable;
+    std::atomic_bool& isRunning;
+    unsigned int id;
+
     SearchInfo info;
     Board board;
-    TranspositionTable ttable;
     AccumulatorList accumulators;
+    EvalCache evalCache;
+    SearchHistory history;
+    unsigned int completedDepth;
+    int nodesUntilTimeCheck;
 
-    std::atomic_bool isRunning;
-    std::atomic_bool isSearching;
-    std::atomic_bool isQuit;
+    // info.numNodes + info.numQNodes, published for Searcher::NodesSearched on other threads. On its own cache line,
+    // the owner writes it at every node
+    alignas(64) std::atomic<unsigned long long> nodesSearched;
+
+    bool isSearching;
+    bool isQuit;
     std::condition_variable cv;
     std::mutex mtx;
     std::thread thread;
 
     void WorkerLoop();
     void DoSearch();
-    void ComputeMovetime();
+
+    // gets the expected reply to the best move, 0 if there is none
+    Move GetPonderMove();
     void IterativeDeepening(Board& board);
 
+    /**
+     * @brief Evaluates the position for the search, from the eval cache or the network. If the lazy eval margin is set
+     * and the psqt-only evaluation is further than the margin outside [alpha, beta], it is returned instead and the
+     * subnet's forward pass is skipped
+     *
+     * @param lazy set to true if the psqt-only evaluation was returned, it must not be stored in the TT
+     * @return Score
+     */
+    Score Evaluate(Score alpha, Score beta, bool& lazy);
+
     template <NodeType nodeT>
     Score Search(int depth, int ply, Score alpha, Score beta, SearchNode* node, const bool nullMoveAllowed = true);
     Score QSearch(int ply, Score alpha, Score beta, SearchNode* node);
 };
 
+class Searcher
+{
+  public:
+    /**
+     * @brief Construct a new Searcher
+     *
+     * @param network the network used for evaluation, it is only read from and can be shared between searchers
+     */
+    Searcher(std::shared_ptr<const NNUE> network);
+    ~Searcher();
+
+    /**
+     * @brief Starts a search for the best move and evaluation for a given position
+     *
+     * @param board the current position
+     * @param constraints search constraints
+     */
+    void StartSearch(const Board& board, const SearchConstraints& constraints);
+
+    void Stop();
+
+    /**
+     * @brief The opponent played the expected move, the ponder search becomes a normal timed search
+     */
+    void PonderHit();
+
+    /**
+     * @brief Sets the number of search threads. Any running search is stopped first
+     *
+     * @param numThreads number of threads (at least 1)
+     */
+    void SetThreads(unsigned int numThreads);
+
+    inline const SearchInfo& GetSearchInfo()
+    {
+        return workers[0]->info;
+    }
+
+    /**
+     * @brief Resizes every thread's eval cache. Any running search is stopped first
+     *
+     * @param kilobytes the new size per thread, 0 disables the cache
+     */
+    void SetEvalCacheSize(unsigned int kilobytes);
+
+    /**
+     * @brief Sets how far outside the window the psqt-only evaluation has to be for the search to use it in place of
+     * the network's. Any running search is stopped first
+     *
+     * @param margin in centipawns, 0 disables lazy evaluation
+     */
+    void SetLazyEvalMargin(Score margin);
+
+    /**
+     * @brief Switches to another network. Any running search is stopped first
+     *
+     * @param network the new network
+     */
+    void SetNetwork(std::shared_ptr<const NNUE> network);
+
+    /**
+     * @brief Resizes the transposition table. Any running search is stopped first
+     *
+     * @param megabytes the new size in megabytes
+     */
+    void SetHashSize(unsigned long long megabytes);
+
+    void ClearTT()
+    {
+        ttable.Clear((unsigned int)workers.size());
+    }
+
+    /**
+     * @brief Gets the total amount of nodes searched by all threads
+     *
+     * @return unsigned long long
+     */
+    unsigned long long NodesSearched() const;
+
+  private:
+    friend class SearchWorker;
+
+    std::shared_ptr<const NNUE> network;
+    unsigned int evalCacheSize; // per thread, in kilobytes
+    Score lazyEvalMargin;       // 0 if disabled
+    SearchConstraints constraints;
+    TranspositionTable ttable;
+    std::atomic_bool isRunning;
+    std::atomic_bool isPondering;
+    std::atomic_bool stopOnPonderhit; // the time limits were already reached while pondering
+    TimeManager timeman;
+    std::vector<std::unique_ptr<SearchWorker>> workers;
+
+    void WaitForSearchFinished();
+    SearchWorker* GetBestWorker();
+};
+
 #endif
\ No newline at end of file
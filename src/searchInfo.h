@@ -9,6 +9,7 @@ struct RootMove
 {
     Move move;
     Score score;
+    unsigned long long nodes; // nodes spent searching this move (all iterations)
 };
 
 struct RootMoveList
@@ -59,6 +60,10 @@ struct SearchInfo
     unsigned long long ttSearchCuts;
     unsigned long long ttQSearchCuts;
 
+    unsigned long long evalCacheHits;   // full evaluations found in the eval cache
+    unsigned long long evalCacheMisses; // full evaluations the network had to compute
+    unsigned long long lazyEvals;       // psqt-only evaluations used in place of the network's
+
     unsigned long long pvHits;        // first move is the best
     unsigned long long orderingNodes; // nodes with at least two moves (where ordering is done)
 
@@ -111,6 +116,9 @@ inline void PrintDebugInfo(SearchInfo& info)
     std::cout << "\nLMR R=3  - " << info.numLMRReducts[2];
     std::cout << "\nLMR R=4  - " << info.numLMRReducts[3];
     std::cout << "\nLMR R=5+ - " << info.numLMRReducts[4];
+    std::cout << "\nEval cache hits - " << info.evalCacheHits;
+    std::cout << "\nEval cache misses - " << info.evalCacheMisses;
+    std::cout << "\nLazy evals - " << info.lazyEvals;
     std::cout << "\nPV Hits - " << info.pvHits;
     std::cout << "\nOrder Nodes - " << info.orderingNodes;
     std::cout << "\n\n----Results----\n\n";
@@ -153,6 +161,8 @@ inline void PrintDebugInfo(SearchInfo& info)
 #define UPDATE_INFO_PVHIT(info) info.pvHits++
 #define UPDATE_INFO_ORDERHIT(info) info.orderingNodes++
 
+#define UPDATE_INFO_LAZYEVAL(info) info.lazyEvals++
+
 #else
 
 #define UPDATE_INFO_QBETACUT(info)
@@ -178,6 +188,8 @@ inline void PrintDebugInfo(SearchInfo& info)
 #define UPDATE_INFO_PVHIT(info)
 #define UPDATE_INFO_ORDERHIT(info)
 
+#define UPDATE_INFO_LAZYEVAL(info)
+
 #endif
 
 #endif
\ No newline at end of file
@@ -2,14 +2,11 @@
 #define SQUARE_H
 
 #include "types.h"
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <string>
 
-// Gives the distance (no diagnals) to the edge of the board from a certain square
-// Where the the closest square to the edge is 0
-
-extern const int (*distToEdge)[64];
-
 constexpr Rank getRank(Square sq)
 {
     return static_cast<Rank>(sq >> 3);
@@ -99,7 +96,41 @@ constexpr unsigned int manhattanDistance(const Square a, const Square b)
     return std::abs(getRank(a) - getRank(b)) + std::abs(getFile(a) - getFile(b));
 }
 
-extern void initSquare();
+// Gives the distance (no diagnals) to the edge of the board from a certain square
+// Where the the closest square to the edge is 0
+alignas(64) inline constexpr auto distToEdgeTable = [] {
+    std::array<std::array<int, 64>, 19> table{}; // [direction + 9][square]
+
+    for (Square s = SQ_A1; s <= SQ_H8; s++)
+    {
+        const int file = getFile(s);
+        const int rank = getRank(s);
+
+        // Straights
+        table[NORTH + 9][s] = 7 - rank;
+        table[SOUTH + 9][s] = rank;
+        table[EAST + 9][s] = 7 - file;
+        table[WEST + 9][s] = file;
+
+        // Diagonal
+        table[NORTH_EAST + 9][s] = std::min(7 - rank, 7 - file);
+        table[NORTH_WEST + 9][s] = std::min(7 - rank, file);
+        table[SOUTH_EAST + 9][s] = std::min(rank, 7 - file);
+        table[SOUTH_WEST + 9][s] = std::min(rank, file);
+
+        // Shortest distance to edge is at index 9
+        table[9][s] = std::min(std::min(7 - rank, rank), std::min(7 - file, file));
+    }
+
+    return table;
+}();
+
+/**
+ * @brief direction from a given square (NONE_DIR gives shortest distance to edge). A square bordering the edge is 0
+ * @example distToEdge[NORTH][SQ_A4]
+ */
+inline constexpr const std::array<int, 64>* distToEdge = distToEdgeTable.data() + 9;
+
 extern std::string sqrToString(Square s);
 
 #endif // SQUARE_H
\ No newline at end of file
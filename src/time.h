@@ -5,18 +5,18 @@
 #include <iostream>
 
 /**
- * @brief Get the time in milliseconds
+ * @brief Get the time in milliseconds from a monotonic clock (only differences between two calls are meaningful)
  *
  * @return unsigned long long
  */
 inline unsigned long long getTime()
 {
-    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 inline unsigned long long getTimeNS()
 {
-    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "timeman.h"
+
+#include <algorithm>
+#include <climits>
+
+TimeManager::TimeManager()
+    : startTime(0), softLimit(ULLONG_MAX), hardLimit(ULLONG_MAX), isManaged(false), prevBestMove(0), stability(0)
+{
+}
+
+void TimeManager::Start(unsigned int remainingTime, unsigned int increment, unsigned int movesToGo,
+                        unsigned int movetime, int numRootMoves)
+{
+    startTime = getTime();
+    prevBestMove = 0;
+    stability = 0;
+
+    if (remainingTime == 0)
+    {
+        isManaged = false;
+        softLimit = hardLimit = movetime ? movetime : ULLONG_MAX;
+        return;
+    }
+
+    isManaged = true;
+
+    const double available = remainingTime > MOVE_OVERHEAD ? remainingTime - MOVE_OVERHEAD : 1;
+    const unsigned int moves = movesToGo ? std::min(movesToGo, (unsigned int)MAX_MOVES_TO_GO) : DEFAULT_MOVES_TO_GO;
+
+    double budget = available / moves + increment * INCREMENT_USAGE;
+
+    // adjust based on how many roots moves exist
+    if (numRootMoves > 30)
+        budget *= 1.5;
+    else if (numRootMoves < 10)
+        budget *= 0.75;
+    else
+        budget *= 0.9;
+
+    softLimit = (unsigned long long)std::max(1.0, std::min(budget, available * MAX_SOFT_USAGE));
+    hardLimit = (unsigned long long)std::max(1.0, std::min(budget * HARD_LIMIT_MULTIPLIER, available * MAX_HARD_USAGE));
+
+    // a fixed movetime is still respected
+    if (movetime)
+        hardLimit = std::min(hardLimit, (unsigned long long)movetime);
+}
+
+bool TimeManager::ShouldStop(Move bestMove, double bestMoveNodeFraction)
+{
+    stability = bestMove == prevBestMove ? std::min(stability + 1, MAX_STABILITY) : 0;
+    prevBestMove = bestMove;
+
+    if (!isManaged)
+        return false;
+
+    // a stable best move needs less time, a changing one more (1.3x - 0.5x)
+    const double stabilityScale = 1.3 - 0.1 * stability;
+
+    // if the best move took most of the nodes the other moves were refuted quickly (1.6x - 0.6x)
+    const double nodeScale = 1.6 - bestMoveNodeFraction;
+
+    return Elapsed() >= softLimit * stabilityScale * nodeScale;
+}
@@ -0,0 +1,89 @@
+#ifndef TIMEMAN_H
+#define TIMEMAN_H
+
+#include "move.h"
+#include "time.h"
+
+#include <atomic>
+
+#define MOVE_OVERHEAD 30        // milliseconds kept in reserve for GUI/network delays
+#define DEFAULT_MOVES_TO_GO 30  // moves the remaining time is split over in sudden death
+#define MAX_MOVES_TO_GO 50      // caps movestogo so a long time control still uses its time
+#define INCREMENT_USAGE 0.75    // fraction of the increment added to each move's budget
+#define MAX_SOFT_USAGE 0.5      // the soft limit never uses more than this part of the remaining time
+#define MAX_HARD_USAGE 0.8      // the hard limit never uses more than this part of the remaining time
+#define HARD_LIMIT_MULTIPLIER 4 // the hard limit is this many times the base budget
+#define MAX_STABILITY 8         // iterations after which the best move counts as fully stable
+#define TIME_CHECK_INTERVAL 512 // the clock is only read every this many search nodes
+
+/**
+ * @brief Decides how long a search may run. There are two limits: the hard limit is checked while searching (every
+ * TIME_CHECK_INTERVAL nodes) and aborts the search, the soft limit is checked after every completed iteration and is
+ * scaled by how stable the best move is and by how much of the search went into the best move
+ */
+class TimeManager
+{
+  public:
+    TimeManager();
+
+    /**
+     * @brief Starts the clock and computes the limits for a search. If remainingTime is 0 the movetime is used as a
+     * fixed limit, if both are 0 the search is unlimited
+     *
+     * @param remainingTime time left on the clock for the side to move (milliseconds)
+     * @param increment increment per move (milliseconds)
+     * @param movesToGo moves until the next time control, 0 for sudden death
+     * @param movetime fixed time for this move (milliseconds)
+     * @param numRootMoves number of legal moves in the root position
+     */
+    void Start(unsigned int remainingTime, unsigned int increment, unsigned int movesToGo, unsigned int movetime,
+               int numRootMoves);
+
+    /**
+     * @brief Gets the time since the search started in milliseconds
+     *
+     * @return unsigned long long
+     */
+    inline unsigned long long Elapsed() const
+    {
+        return getTime() - startTime;
+    }
+
+    inline unsigned long long GetStartTime() const
+    {
+        return startTime;
+    }
+
+    /**
+     * @brief Restarts the clock without changing the limits. Used on ponderhit, our clock only starts running then
+     */
+    inline void RestartClock()
+    {
+        startTime = getTime();
+    }
+
+    inline bool HardLimitReached() const
+    {
+        return Elapsed() >= hardLimit;
+    }
+
+    /**
+     * @brief Called after every completed iteration, checks if starting another iteration is worth it
+     *
+     * @param bestMove best move of the iteration
+     * @param bestMoveNodeFraction fraction of all root nodes that were spent on the best move (0-1)
+     * @return bool true if the search should stop
+     */
+    bool ShouldStop(Move bestMove, double bestMoveNodeFraction);
+
+  private:
+    std::atomic<unsigned long long> startTime; // can be restarted by the UCI thread while searching
+    unsigned long long softLimit;
+    unsigned long long hardLimit;
+    bool isManaged; // false for fixed movetime or infinite searches, the soft limit isn't used then
+
+    Move prevBestMove;
+    int stability; // number of iterations in a row the best move didn't change
+};
+
+#endif
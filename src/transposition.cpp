@@ -1,94 +1,132 @@
 #include "transposition.h"
-#include "random.h"
-#include <cmath>
+#include <algorithm>
+#include <cassert>
 #include <cstring>
 #include <iostream>
+#include <thread>
+#include <vector>
 
-alignas(64) Key boardHashes[64][(KING | BLACK) + 1];
-Key isBlackHash;
-Key castleRightsHash[16];
-Key enPassantHash[8];
-
-void TranspositionEntry::Set(Key key, Score score, Move move, unsigned char depth, unsigned char age, NodeBound bound)
+void TranspositionEntry::Set(Key key, Score score, Score eval, Move move, unsigned char depth, unsigned char age,
+                             NodeBound bound)
 {
-    this->key = key >> 32ULL;
+    this->key = key;
     this->score = (int16_t)score;
+    this->eval = (int16_t)eval;
     this->move = move.getMove();
     this->depth = depth;
     this->flags = ((unsigned char)bound << 6) | age;
 }
 
-TranspositionTable::TranspositionTable(unsigned long kbytes) : buckets(nullptr)
+TranspositionTable::TranspositionTable(unsigned long long megabytes) : buckets(nullptr), age(0), numBuckets(0), memory()
 {
-    assert(kbytes != 0);
-
-    // round down to nearest power of two
-    unsigned long long bytes = (1ULL << static_cast<unsigned long long>(std::floor(std::log2l(kbytes)))) * 1024ULL;
-    Resize(bytes);
+    assert(megabytes != 0);
+    Resize(megabytes);
 }
 
 TranspositionTable::~TranspositionTable()
 {
-    operator delete[](this->buckets, std::align_val_t(64));
+    LargeFree(memory);
 }
 
-void TranspositionTable::Resize(unsigned long long bytes)
+void TranspositionTable::Resize(unsigned long long megabytes, unsigned int threads)
 {
-    numBuckets = bytes / sizeof(TranspositionBucket);
-    std::cout << "Num Buckets: " << this->numBuckets << " (" << bytes << " bytes)" << std::endl;
+    const unsigned long long previousBuckets = this->buckets == &fallbackBucket ? 0 : numBuckets;
+
+    LargeFree(memory);
+    memory = LargeAllocation();
+    this->buckets = nullptr;
 
-    if (this->buckets)
+    // halve the size until the allocation succeeds
+    for (; megabytes > 0 && !this->buckets; megabytes /= 2)
     {
-        operator delete[](this->buckets, std::align_val_t(64));
+        numBuckets = megabytes * 1024ULL * 1024ULL / sizeof(TranspositionBucket);
+        memory = LargeAlloc(numBuckets * sizeof(TranspositionBucket));
+        this->buckets = static_cast<TranspositionBucket*>(memory.ptr);
+
+        if (!this->buckets)
+            std::cout << "info string Failed to allocate " << megabytes << " MB for the transposition table"
+                      << std::endl;
     }
 
-    this->buckets = new (std::align_val_t(64)) TranspositionBucket[numBuckets];
-    age = 0;
+    // nothing fit: go back to the previous size, whose memory was just released, or as a last resort to the single
+    // bucket inside the table so probing and storing stay valid
+    if (!this->buckets && previousBuckets)
+    {
+        numBuckets = previousBuckets;
+        memory = LargeAlloc(numBuckets * sizeof(TranspositionBucket));
+        this->buckets = static_cast<TranspositionBucket*>(memory.ptr);
+    }
 
-    memset(buckets, 0, numBuckets * sizeof(TranspositionBucket));
+    if (!this->buckets)
+    {
+        numBuckets = 1;
+        memory = LargeAllocation();
+        this->buckets = &fallbackBucket;
+        std::cout << "info string Failed to allocate the transposition table, searching with a single bucket"
+                  << std::endl;
+    }
+
+    std::cout << "info string Hash: " << numBuckets * sizeof(TranspositionBucket) / (1024 * 1024) << " MB ("
+              << numBuckets << " buckets, " << LargeAllocDescription(memory) << ")" << std::endl;
+
+    Clear(threads);
 }
 
-TranspositionEntry* TranspositionTable::GetEntry(Key key)
+bool TranspositionTable::Probe(Key key, TranspositionEntry& entry)
 {
-    unsigned long long index = key & (this->numBuckets - 1);
-    TranspositionBucket* bucket = &this->buckets[index];
-    uint32_t intKey = key >> 32ULL;
+    TranspositionBucket* bucket = GetBucket(key);
 
-    for (TranspositionEntry* entry = bucket->entries; entry < bucket->entries + BUCKET_SIZE; entry++)
+    for (TranspositionSlot& slot : bucket->entries)
     {
-        if (entry->key == intKey)
+        const uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if ((slot.keyXorData.load(std::memory_order_relaxed) ^ data) != key)
+            continue;
+
+        entry = TranspositionEntry::Unpack(key, data);
+        if (entry.getAge() != age)
         {
-            return entry;
+            entry.setAge(age); // reset the age for this node
+            slot.Store(entry);
         }
+        return true;
     }
 
-    return nullptr;
+    return false;
 }
 
-void TranspositionTable::SetEntry(Key zobrist, Score score, int depth, NodeBound bound, Move bestMove)
+void TranspositionTable::SetEntry(Key zobrist, Score score, Score eval, int depth, NodeBound bound, Move bestMove)
 {
-    unsigned long long index = zobrist & (this->numBuckets - 1); // much faster than modulo
-    TranspositionBucket* bucket = &this->buckets[index];
+    TranspositionBucket* bucket = GetBucket(zobrist);
 
-    TranspositionEntry* entry = nullptr;
+    TranspositionSlot* replace = nullptr;
     int maxPoints = -__INT32_MAX__;
 
-    for (TranspositionEntry& e : bucket->entries)
+    for (TranspositionSlot& slot : bucket->entries)
     {
-        if (!e.key) // just fill entry if empty
+        const uint64_t data = slot.data.load(std::memory_order_relaxed);
+        const Key key = slot.keyXorData.load(std::memory_order_relaxed) ^ data;
+        if (!data && !key) // just fill entry if empty
         {
-            entry = &e;
+            replace = &slot;
             break;
         }
 
-        if (e.key == zobrist >> 32ULL) // if we find the position in the table
+        TranspositionEntry e = TranspositionEntry::Unpack(key, data);
+
+        if (e.key == zobrist) // if we find the position in the table
         {
-            e.setAge(age);
-            if (depth < e.depth)
+            if (depth < e.depth || (e.getNodeBound() == NodeBound::Exact && bound != NodeBound::Exact))
+            {
+                if (e.getAge() != age || (e.eval == EVAL_NONE && eval != EVAL_NONE))
+                {
+                    e.setAge(age);
+                    if (e.eval == EVAL_NONE)
+                        e.eval = (int16_t)eval;
+                    slot.Store(e);
+                }
                 return;
-            if (e.getNodeBound() == NodeBound::Exact && bound != NodeBound::Exact)
-                return;
-            entry = &e;
+            }
+            replace = &slot;
             break;
         }
 
@@ -104,58 +142,60 @@ void TranspositionTable::SetEntry(Key zobrist, Score score, int depth, NodeBound
 
         if (maxPoints < points)
         {
-            entry = &e;
+            replace = &slot;
             maxPoints = points;
         }
     }
 
-    entry->Set(zobrist, score, bestMove, (unsigned char)depth, age, bound);
+    TranspositionEntry entry;
+    entry.Set(zobrist, score, eval, bestMove, (unsigned char)depth, age, bound);
+    replace->Store(entry);
 }
 
-float TranspositionTable::GetFull()
+int TranspositionTable::Hashfull() const
 {
+    const unsigned long long sampled = std::min(1000ULL, this->numBuckets);
+
+    // entries of older searches are free to be replaced, they don't count
     unsigned long long valid = 0;
-    for (unsigned long long i = 0; i < this->numBuckets; i++)
+    for (unsigned long long i = 0; i < sampled; i++)
     {
-        for (TranspositionEntry& e : buckets[i].entries)
-            if (e.key)
+        for (TranspositionSlot& slot : buckets[i].entries)
+        {
+            const uint64_t data = slot.data.load(std::memory_order_relaxed);
+            const bool used = data | slot.keyXorData.load(std::memory_order_relaxed);
+            if (used && TranspositionEntry::Unpack(0, data).getAge() == age)
                 valid++;
+        }
     }
 
-    return (float)valid / ((float)numBuckets * BUCKET_SIZE);
+    return (int)(valid * 1000 / (sampled * BUCKET_SIZE));
 }
 
-void TranspositionTable::Clear()
+void TranspositionTable::Clear(unsigned int threads)
 {
     age = 0;
-    std::memset(this->buckets, 0, this->numBuckets * sizeof(TranspositionBucket));
-}
 
-void TranspositionTable::Prefetch(Key zobrist)
-{
-    unsigned long long index = zobrist & (this->numBuckets - 1); // much faster than modulo
-    __builtin_prefetch(&this->buckets[index], 0, 1);
-}
+    threads = std::max(1u, threads);
+    const unsigned long long chunk = (this->numBuckets + threads - 1) / threads;
 
-void InitZobrist()
-{
-    for (int i = 0; i < 64; i++)
-    {
-        for (int p = 0; p < 15; p++)
-        {
-            boardHashes[i][p] = RandNum();
-        }
-    }
+    auto clearRange = [this, chunk](unsigned int i) {
+        const unsigned long long start = std::min(this->numBuckets, chunk * i);
+        const unsigned long long end = std::min(this->numBuckets, start + chunk);
+        std::memset(static_cast<void*>(this->buckets + start), 0, (end - start) * sizeof(TranspositionBucket));
+    };
 
-    isBlackHash = RandNum();
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < threads; i++)
+        workers.emplace_back(clearRange, i);
 
-    for (int i = 0; i < 16; i++)
-    {
-        castleRightsHash[i] = RandNum();
-    }
+    clearRange(0);
 
-    for (int i = 0; i < 8; i++)
-    {
-        enPassantHash[i] = RandNum();
-    }
+    for (std::thread& t : workers)
+        t.join();
+}
+
+void TranspositionTable::Prefetch(Key zobrist)
+{
+    __builtin_prefetch(GetBucket(zobrist), 0, 1);
 }
\ No newline at end of file
@@ -1,12 +1,15 @@
 #ifndef TRANSPOSITION_H
 #define TRANSPOSITION_H
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 
+#include "largeAlloc.h"
 #include "move.h"
 #include "types.h"
 
-#define BUCKET_SIZE 3
+#define BUCKET_SIZE 4
 
 enum class NodeBound : unsigned char
 {
@@ -15,16 +18,34 @@ enum class NodeBound : unsigned char
     Lower
 };
 
+#define EVAL_NONE (-32768) // stored static eval when there is none (in check)
+
+/**
+ * @brief A decoded copy of a transposition table entry. In the table every entry is stored as two 64 bit words: the
+ * data and the zobrist hash xor'ed with the data. A probe only accepts an entry if the xor of both words gives back the
+ * hash, so an entry torn by two threads writing at the same time is seen as a miss instead of being used (lockless
+ * hashing), and the full hash is verified.
+ * @paragraph
+ * The format of the data word is as follows:
+ *  (Bit)    (Description)
+ *  0  - 15 : score
+ *  16 - 31 : best move
+ *  32 - 47 : static eval
+ *  48 - 55 : depth
+ *  56 - 63 : flags (nodebound << 6 | age)
+ */
 struct TranspositionEntry
 {
-    uint32_t key;  // the upper 32 bits of the zobrist hash
+    Key key;       // the zobrist hash
     int16_t score; // The score of this position at depth
     uint16_t move; // best move to be played
+    int16_t eval;  // static evaluation of the position, EVAL_NONE if there is none
 
     unsigned char depth; // the depth the score was calculated at
     unsigned char flags; // the age at which this position is and the node bound
                          // format: nodebound << 6 | age
-    void Set(Key key, Score score, Move move, unsigned char depth, unsigned char age, NodeBound bound);
+
+    void Set(Key key, Score score, Score eval, Move move, unsigned char depth, unsigned char age, NodeBound bound);
 
     inline NodeBound getNodeBound() const
     {
@@ -40,44 +61,100 @@ struct TranspositionEntry
     {
         flags = (flags & 0xc0) | (age & 0x3f);
     }
-} __attribute__((packed));
 
-struct TranspositionBucket
+    inline uint64_t Pack() const
+    {
+        return (uint64_t)(uint16_t)score | (uint64_t)move << 16 | (uint64_t)(uint16_t)eval << 32 |
+               (uint64_t)depth << 48 | (uint64_t)flags << 56;
+    }
+
+    static inline TranspositionEntry Unpack(Key key, uint64_t data)
+    {
+        TranspositionEntry entry;
+        entry.key = key;
+        entry.score = (int16_t)(data & 0xffff);
+        entry.move = (data >> 16) & 0xffff;
+        entry.eval = (int16_t)((data >> 32) & 0xffff);
+        entry.depth = (data >> 48) & 0xff;
+        entry.flags = data >> 56;
+        return entry;
+    }
+};
+
+struct TranspositionSlot
 {
-    TranspositionEntry entries[BUCKET_SIZE];
-    char padding[2]; // pad to 32 bytes
+    std::atomic<uint64_t> keyXorData;
+    std::atomic<uint64_t> data;
+
+    inline void Store(const TranspositionEntry& entry)
+    {
+        const uint64_t packed = entry.Pack();
+        keyXorData.store(entry.key ^ packed, std::memory_order_relaxed);
+        data.store(packed, std::memory_order_relaxed);
+    }
+};
+
+struct alignas(64) TranspositionBucket
+{
+    TranspositionSlot entries[BUCKET_SIZE];
 };
 
-static_assert(sizeof(TranspositionEntry) == 10, "TranspositionEntry is not 10 bytes!");
-static_assert(sizeof(TranspositionBucket) == 32, "TranspositionBucket is not 32 bytes!");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "64 bit atomics must be lock free!");
+static_assert(sizeof(TranspositionBucket) == 64, "TranspositionBucket is not 64 bytes!");
 class TranspositionTable
 {
   public:
     /**
      * @brief Construct a new Transposition Table object
      *
-     * @param size the size in kilobytes of the transposition table entry array
+     * @param megabytes the size in megabytes of the transposition table entry array
      */
-    TranspositionTable(unsigned long kilobytes);
+    TranspositionTable(unsigned long long megabytes);
     ~TranspositionTable();
 
     TranspositionTable(const TranspositionTable&) = delete;
     TranspositionTable& operator=(const TranspositionTable&) = delete;
 
-    void Resize(unsigned long long bytes);
+    /**
+     * @brief Reallocates the table, all entries are lost. Any size is allowed, it doesn't need to be a power of two. If
+     * the size can't be allocated, smaller sizes are tried, then the previous size
+     *
+     * @param megabytes the new size in megabytes
+     * @param threads number of threads used to clear the new table
+     */
+    void Resize(unsigned long long megabytes, unsigned int threads = 1);
 
     inline void IncrementAge()
     {
         age = (age + 1) & 0x3f;
     };
 
-    TranspositionEntry* GetEntry(Key key);
+    /**
+     * @brief Looks up a position. Safe to call while other threads store into the table. On a hit the entry's age is
+     * refreshed
+     *
+     * @param key zobrist hash of the position
+     * @param entry receives a copy of the entry if found
+     * @return true if the position was found
+     */
+    bool Probe(Key key, TranspositionEntry& entry);
 
-    void SetEntry(Key zobrist, Score score, int depth, NodeBound bound, Move bestMove);
+    void SetEntry(Key zobrist, Score score, Score eval, int depth, NodeBound bound, Move bestMove);
 
-    float GetFull(); // gets how full the table is, from 0-1
+    /**
+     * @brief Gets how full the table is in permill, sampled from the first 1000 buckets like the UCI hashfull. Only
+     * entries of the current age count
+     *
+     * @return int
+     */
+    int Hashfull() const;
 
-    void Clear();
+    /**
+     * @brief Clears every entry, the work is split between the given number of threads
+     *
+     * @param threads number of threads
+     */
+    void Clear(unsigned int threads = 1);
 
     void Prefetch(Key zobrist);
 
@@ -87,16 +164,58 @@ class TranspositionTable
     }; // gets how full the table is, from 0-1
 
   private:
+    // maps a zobrist hash onto [0, numBuckets) using the upper bits of the hash (no power of two size needed)
+    inline TranspositionBucket* GetBucket(Key zobrist) const
+    {
+        return &buckets[(unsigned long long)(((unsigned __int128)zobrist * numBuckets) >> 64)];
+    }
+
     TranspositionBucket* buckets;
     unsigned char age;
     unsigned long long numBuckets;
+    LargeAllocation memory; // backing memory of buckets
+
+    TranspositionBucket fallbackBucket; // used as the whole table if no memory could be allocated
 };
 
-extern Key boardHashes[64][(KING | BLACK) + 1];
-extern Key isBlackHash;
-extern Key castleRightsHash[16];
-extern Key enPassantHash[8];
+/**
+ * @brief Gets the n-th zobrist key, the output of splitmix64 from a fixed seed, so the keys are generated at compile
+ * time and are the same in every build and every run
+ */
+constexpr Key ZobristKey(unsigned int n)
+{
+    Key z = 0x2545F4914F6CDD1DULL + (n + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+#define NUM_ZOBRIST_PIECES ((KING | BLACK) + 1)
 
-extern void InitZobrist();
+alignas(64) inline constexpr auto boardHashes = [] {
+    std::array<std::array<Key, NUM_ZOBRIST_PIECES>, 64> table{}; // [square][piece]
+    for (int i = 0; i < 64; i++)
+    {
+        for (int p = 0; p < NUM_ZOBRIST_PIECES; p++)
+            table[i][p] = ZobristKey(i * NUM_ZOBRIST_PIECES + p);
+    }
+    return table;
+}();
+
+inline constexpr Key isBlackHash = ZobristKey(64 * NUM_ZOBRIST_PIECES);
+
+alignas(64) inline constexpr auto castleRightsHash = [] {
+    std::array<Key, 16> table{};
+    for (int i = 0; i < 16; i++)
+        table[i] = ZobristKey(64 * NUM_ZOBRIST_PIECES + 1 + i);
+    return table;
+}();
+
+alignas(64) inline constexpr auto enPassantHash = [] {
+    std::array<Key, 8> table{}; // [file]
+    for (int i = 0; i < 8; i++)
+        table[i] = ZobristKey(64 * NUM_ZOBRIST_PIECES + 17 + i);
+    return table;
+}();
 
 #endif
\ No newline at end of file
@@ -4,7 +4,6 @@
 #include <cstdint>
 
 // #define MAGIC_GEN (does nothing right now)
-// #define PERFT (enable to get faster perft times)
 #define MAX_DEPTH 256
 
 enum Color : int8_t
@@ -165,5 +164,6 @@ struct MoveList;
 class Move;
 class Engine;
 class Board;
+class NNUE;
 
 #endif // TYPES_H
\ No newline at end of file
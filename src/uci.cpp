@@ -1,8 +1,12 @@
 #include "uci.h"
 
+#include "magic.h"
+#include "nnue/embeddedNet.h"
+#include "nnue/nnue.h"
 #include "search.h"
 #include "transposition.h"
 #include "types.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -32,6 +36,14 @@ void Interface::run()
         else if (input == "uci")
             std::cout << "id name PioneerV4.1\n"
                       << "id author Pioneer\n"
+                      << "option name Hash type spin default 64 min 1 max 33554432\n"
+                      << "option name Threads type spin default 1 min 1 max 1024\n"
+                      << "option name Ponder type check default false\n"
+                      << "option name EvalCache type spin default " << DEFAULT_EVAL_CACHE_KB << " min 0 max 1048576\n"
+                      << "option name EvalFile type string default " << DefaultEvalFile() << "\n"
+                      << "option name LazyEvalMargin type spin default " << DEFAULT_LAZY_EVAL_MARGIN
+                      << " min 0 max 10000\n"
+                      << "option name PerftHash type spin default 0 min 0 max 33554432\n"
                       << "uciok\n";
 
         else if (input == "isready")
@@ -43,6 +55,30 @@ void Interface::run()
         else if (input == "d")
             engine.print();
 
+        else if (word == "setoption")
+        {
+            // setoption name <id> value <x>
+            std::string name, value;
+            parse >> word;
+            while (parse >> word && word != "value")
+                name += (name.empty() ? "" : " ") + word;
+            while (parse >> word)
+                value += (value.empty() ? "" : " ") + word;
+
+            if (name == "Threads")
+                engine.setThreads(std::max(1, atoi(value.c_str())));
+            else if (name == "Hash")
+                engine.setHash(std::max(1LL, atoll(value.c_str())));
+            else if (name == "EvalCache")
+                engine.setEvalCache(std::clamp(atoi(value.c_str()), 0, 1048576));
+            else if (name == "EvalFile")
+                engine.setEvalFile(value);
+            else if (name == "LazyEvalMargin")
+                engine.setLazyEvalMargin(std::clamp(atoi(value.c_str()), 0, 10000));
+            else if (name == "PerftHash")
+                engine.setPerftHash(std::max(0LL, atoll(value.c_str())));
+        }
+
         else if (word == "position")
         {
             parse >> word;
@@ -104,6 +140,10 @@ void Interface::run()
                 int movetime = 0;
                 int wtime = 0;
                 int btime = 0;
+                int winc = 0;
+                int binc = 0;
+                int movestogo = 0;
+                bool ponder = false;
                 do
                 {
                     if (word == "depth")
@@ -131,15 +171,36 @@ void Interface::run()
                         parse >> word;
                         btime = atoi(word.c_str());
                     }
+                    else if (word == "winc")
+                    {
+                        parse >> word;
+                        winc = atoi(word.c_str());
+                    }
+                    else if (word == "binc")
+                    {
+                        parse >> word;
+                        binc = atoi(word.c_str());
+                    }
+                    else if (word == "movestogo")
+                    {
+                        parse >> word;
+                        movestogo = atoi(word.c_str());
+                    }
+                    else if (word == "ponder")
+                        ponder = true;
                 } while (parse >> word);
 
-                engine.go(depth, nodes, movetime, wtime, btime);
+                engine.go(depth, nodes, movetime, wtime, btime, winc, binc, movestogo, ponder);
             }
         }
         else if (word == "stop")
         {
             engine.stop();
         }
+        else if (word == "ponderhit")
+        {
+            engine.ponderhit();
+        }
         else if (word == "makemove")
         {
             parse >> word;
@@ -150,11 +211,38 @@ void Interface::run()
             engine.undomove();
         else if (word == "eval")
             engine.eval();
+        else if (word == "evalfens")
+        {
+            parse >> word;
+            engine.evalFens(word);
+        }
+        else if (word == "sliderbench")
+            BenchmarkSliders();
+        else if (word == "perftsuite")
+        {
+            // perftsuite <epd file> [max depth], e.g. perftsuite tools/perft/standard.epd 5
+            std::string filename, maxDepth;
+            parse >> filename >> maxDepth;
+            if (filename.empty())
+                std::cout << "usage: perftsuite <file> [max depth]" << std::endl;
+            else
+                engine.perftSuite(filename, atoi(maxDepth.c_str()));
+        }
         else if (word == "check")
         {
             parse >> word;
             Move move(word);
             engine.isCheck(move);
         }
+        else if (word == "convertnet")
+        {
+            // convertnet <trainer file> <native file>
+            std::string input, output;
+            parse >> input >> output;
+            if (input.empty() || output.empty())
+                std::cout << "usage: convertnet <input> <output>" << std::endl;
+            else if (NNUE::Convert(input, output))
+                std::cout << "info string converted " << input << " to " << output << std::endl;
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,17 @@
+#include "../../src/nnue/nnue.h"
+
+#include <iostream>
+
+/**
+ * @brief Same as the engine's convertnet command: converts a network in the trainer's format to the native format
+ */
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <input> <output>" << std::endl;
+        return 1;
+    }
+
+    return NNUE::Convert(argv[1], argv[2]) ? 0 : 1;
+}